@@ -0,0 +1,249 @@
+#include "ClientGame.h"
+#include "ServerGame.h"
+#include "GameClient.h"
+#include "GameWorld.h"
+#include "GameLevel.h"
+#include "PhysicsSystem.h"
+#include "PhysicsObject.h"
+#include "SnapshotBuilder.h"
+#include "SpawnBuilder.h"
+#include "NetworkStats.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+const int	maxPendingInputs	= 64;
+
+ClientGame::ClientGame(GameLevel& level, GameClient& client, float tickRate)
+	: level(level), world(level.GetWorld()), physics(level.GetPhysics()), client(client), networkObjects(level.GetNetworkObjects()) {
+	this->tickRate			= tickRate;
+	lastSnapshotSequence	= -1;
+	snapshotAckBits			= 0;
+	newestSnapshotTick		= -1;
+
+	clientTick				= -1.0f;
+	interpolationDelay		= 2.0f;
+	maxExtrapolation		= 5.0f;
+
+	localPlayer				= nullptr;
+	inputSequence			= -1;
+	inputRedundancy			= 4;
+	lastReconciledInput		= -1;
+}
+
+ClientGame::~ClientGame() {
+}
+
+void ClientGame::RegisterPacketHandlers() {
+	client.RegisterPacketHandler(Snapshot_State, this);
+	client.RegisterPacketHandler(Player_State, this, sizeof(PlayerStatePacket) - sizeof(GamePacket));
+	client.RegisterPacketHandler(Spawn_State, this);
+	client.RegisterPacketHandler(Player_Connected, this);
+	client.RegisterPacketHandler(Player_Disconnected, this);
+}
+
+void ClientGame::SetQuantisation(const StateQuantisation& q) {
+	quantisation = q;
+}
+
+void ClientGame::SetInputRedundancy(int count) {
+	inputRedundancy = std::clamp(count, 1, ClientPacket::MaxInputs);
+	if ((int)recentInputs.size() > inputRedundancy) {
+		recentInputs.resize(inputRedundancy);
+	}
+}
+
+/*
+Each tick's input gets a sequence number and is applied to our own player
+straight away, rather than waiting for the server to send the result back.
+It's kept until the server says it has applied it too, in case we need to
+replay it over a correction.
+*/
+void ClientGame::Tick(PlayerInput input) {
+	input.sequence	= ++inputSequence;
+	input.viewTick	= clientTick - interpolationDelay;
+	input.Quantise();
+
+	recentInputs.insert(recentInputs.begin(), input);
+	if ((int)recentInputs.size() > inputRedundancy) {
+		recentInputs.pop_back();
+	}
+
+	if (localPlayer) {
+		//Grapple against what we can see - the server rewinds to check the same thing
+		ServerGame::UpdatePlayerGrapple(localPlayer, input, [&](const Ray& r, RayCollision& collision) {
+			Ray ray = r;
+			return world.Raycast(ray, collision, true, localPlayer, { LAYER_PLAYER });
+		});
+		ServerGame::ApplyPlayerInput(localPlayer, input, 1.0f / tickRate);
+		pendingInputs.emplace_back(input);
+		if ((int)pendingInputs.size() > maxPendingInputs) {
+			pendingInputs.erase(pendingInputs.begin());
+		}
+	}
+	//Every input packet doubles as an acknowledgement of the snapshots we've received
+	ClientPacket newPacket;
+	newPacket.lastID	= lastSnapshotSequence;
+	newPacket.ackBits	= snapshotAckBits;
+	newPacket.WriteInputs(recentInputs.data(), (int)recentInputs.size());
+	client.SendPacket(newPacket);
+}
+
+/*
+The server's state for our player is the truth, but it's a round trip
+old. Snap to it, then replay every input it hasn't seen yet, using the
+same integration the physics system does, to get back to the present.
+*/
+void ClientGame::ReconcilePlayer(const PlayerStatePacket& state) {
+	if (state.lastInput < lastReconciledInput) {
+		return; //arrived out of order
+	}
+	if (state.networkID < 0 || state.networkID >= (int)networkObjects.size() || !networkObjects[state.networkID]) {
+		return; //our player hasn't been spawned here yet
+	}
+	lastReconciledInput = state.lastInput;
+
+	GameObject* player = &networkObjects[state.networkID]->GetGameObject();
+	bool		wasPredicting	= player == localPlayer;
+	Vector3		predicted		= player->GetTransform().GetPosition();
+	localPlayer = player;
+
+	pendingInputs.erase(std::remove_if(pendingInputs.begin(), pendingInputs.end(),
+		[&](const PlayerInput& i) { return i.sequence <= state.lastInput; }), pendingInputs.end());
+
+	PhysicsObject* physicsObject = localPlayer->GetPhysicsObject();
+	localPlayer->GetTransform()
+		.SetPosition(state.position)
+		.SetOrientation(state.orientation);
+	physicsObject->SetLinearVelocity(state.linearVelocity);
+	physicsObject->SetAngularVelocity(state.angularVelocity);
+	physicsObject->ClearForces();
+
+	float tickDT = 1.0f / tickRate;
+	for (const PlayerInput& input : pendingInputs) {
+		ServerGame::ApplyPlayerInput(localPlayer, input, tickDT);
+		physics.UpdateObject(*localPlayer, tickDT);
+	}
+
+	if (wasPredicting) {
+		float error = (localPlayer->GetTransform().GetPosition() - predicted).Length();
+		if (error > 0.0f) {
+			stats.corrections++;
+			stats.correctionTotal += error;
+			stats.correctionWorst = std::max(stats.correctionWorst, error);
+		}
+	}
+}
+
+/*
+The client keeps its own estimate of the server's tick, running at the tick
+rate and pulled gently towards the ticks in arriving snapshots, so that
+jittery arrival times don't show up as jittery movement.
+*/
+void ClientGame::UpdateClientClock(int serverTick) {
+	if (clientTick < 0.0f || std::abs(serverTick - clientTick) > tickRate) {
+		clientTick = (float)serverTick;
+	}
+	else {
+		clientTick += (serverTick - clientTick) * 0.05f;
+	}
+}
+
+void ClientGame::Update(float dt) {
+	if (clientTick < 0.0f) {
+		return;
+	}
+	clientTick += dt * tickRate;
+
+	float renderTick = clientTick - interpolationDelay;
+	for (NetworkObject* o : networkObjects) {
+		if (!o || &o->GetGameObject() == localPlayer) {
+			continue; //predicted instead - its states still get read, for delta baselines
+		}
+		o->UpdateInterpolation(renderTick, maxExtrapolation);
+	}
+}
+
+/*
+Spawns come reliably and in order, so a despawn is never read before the
+spawn it undoes. Whatever the server sent with a spawn is the state the
+object's later snapshots are deltas against, so it goes into its history.
+*/
+void ClientGame::ReadSpawns(GamePacket& packet) {
+	SpawnBuilder::ReadEntries(packet, quantisation, [&](int stateID, const SpawnEntry& entry) {
+		if (!entry.spawned) {
+			if (entry.networkID < (int)networkObjects.size() && networkObjects[entry.networkID]
+				&& &networkObjects[entry.networkID]->GetGameObject() == localPlayer) {
+				localPlayer = nullptr;
+				pendingInputs.clear();
+			}
+			level.DespawnNetworkObject(entry.networkID);
+			return;
+		}
+		NetworkObject* n = level.SpawnNetworkObject(entry.prefab, entry.networkID);
+		if (n) {
+			n->ReadBaseline(entry.state, stateID, quantisation);
+		}
+	});
+}
+
+void ClientGame::AcknowledgeSnapshot(int sequence) {
+	int age = lastSnapshotSequence - sequence;
+	if (lastSnapshotSequence < 0) {
+		snapshotAckBits = 0;
+		lastSnapshotSequence = sequence;
+	}
+	else if (age <= -32) {
+		//Too far to shift the mask by - only the old newest can still be in range
+		snapshotAckBits = (age == -32) ? 1u << 31 : 0;
+		lastSnapshotSequence = sequence;
+	}
+	else if (age < 0) {
+		snapshotAckBits = (snapshotAckBits << -age) | (1u << (-age - 1));
+		lastSnapshotSequence = sequence;
+	}
+	else if (age > 0 && age <= 32) {
+		snapshotAckBits |= 1u << (age - 1);
+	}
+}
+
+void ClientGame::ReceivePacket(int type, GamePacket* payload, int source) {
+	switch (type) {
+		case Snapshot_State: {
+			//Out of date by the time it got here - it isn't acknowledged either,
+			//so the server won't build deltas against it
+			if (SnapshotBuilder::ReadHeader(*payload).stateID < newestSnapshotTick) {
+				stats.staleSnapshots++;
+				return;
+			}
+			const StateQuantisation& q = quantisation;
+			int sequence	= -1;
+			int serverTick	= -1;
+			int fullEntries	= 0;
+			int entries		= 0;
+			SnapshotBuilder::ReadEntries(*payload, q, [&](const SnapshotHeader& header, const SnapshotEntry& entry) {
+				sequence	= header.sequence;
+				serverTick	= header.stateID;
+				fullEntries	+= entry.fullState ? 1 : 0;
+				entries++;
+				if (entry.objectID < (int)networkObjects.size() && networkObjects[entry.objectID]) {
+					networkObjects[entry.objectID]->ReadPacket(header, entry, q);
+				}
+			});
+			if (sequence >= 0) {
+				AcknowledgeSnapshot(sequence);
+				UpdateClientClock(serverTick);
+				newestSnapshotTick = std::max(newestSnapshotTick, serverTick);
+			}
+			client.GetStats().RecordSnapshotEntries(fullEntries, entries - fullEntries);
+			stats.snapshots++;
+			stats.snapshotBytes += payload->GetTotalSize();
+		}break;
+		case Player_State: {
+			ReconcilePlayer(*(PlayerStatePacket*)payload);
+		}break;
+		case Spawn_State: {
+			ReadSpawns(*payload);
+		}break;
+	}
+}
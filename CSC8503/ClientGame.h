@@ -0,0 +1,92 @@
+#pragma once
+#include "NetworkBase.h"
+#include "NetworkObject.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameClient;
+		class GameWorld;
+		class GameLevel;
+		class PhysicsSystem;
+
+		/*
+		The client side of a networked game - reads snapshots into the world,
+		draws everything else a little in the past so it can be interpolated,
+		and predicts our own player from the inputs it's given. Like
+		ServerGame, there's nothing in here that needs a window, so bots and
+		tests can run it too - whoever owns it decides where input comes from.
+		Objects the server spawns and despawns are created in, and removed
+		from, the level the game is given.
+		*/
+		class ClientGame : public PacketReceiver {
+		public:
+			struct Stats {
+				int		snapshots		= 0;
+				int		snapshotBytes	= 0;
+				int		staleSnapshots	= 0;	//older than one already read, so dropped unread
+				int		corrections		= 0;	//server states that moved our predicted player
+				float	correctionTotal = 0.0f;	//how far they moved it
+				float	correctionWorst	= 0.0f;
+			};
+
+			ClientGame(GameLevel& level, GameClient& client, float tickRate = 20.0f);
+			~ClientGame();
+
+			void RegisterPacketHandlers();
+			void SetQuantisation(const StateQuantisation& q);
+			//How many of the newest inputs go in every packet, so a lost one can be made up
+			void SetInputRedundancy(int count);
+
+			//Once per network tick. The sequence number and view tick are filled in here
+			void Tick(PlayerInput input);
+			//Every frame, to move the interpolated objects along
+			void Update(float dt);
+
+			void ReceivePacket(int type, GamePacket* payload, int source) override;
+
+			GameObject* GetLocalPlayer() const {
+				return localPlayer;
+			}
+			//The newest server tick a snapshot has been received for
+			int GetNewestSnapshotTick() const {
+				return newestSnapshotTick;
+			}
+			const Stats& GetStats() const {
+				return stats;
+			}
+
+		protected:
+			void AcknowledgeSnapshot(int sequence);
+			void UpdateClientClock(int serverTick);
+			void ReconcilePlayer(const PlayerStatePacket& state);
+			void ReadSpawns(GamePacket& packet);
+
+			GameLevel&		level;
+			GameWorld&		world;
+			PhysicsSystem&	physics;
+			GameClient&		client;
+
+			const std::vector<NetworkObject*>&	networkObjects;
+			StateQuantisation					quantisation;
+
+			int			lastSnapshotSequence;	//newest snapshot datagram received
+			uint32_t	snapshotAckBits;		//which of the 32 datagrams before that were received
+			int			newestSnapshotTick;
+
+			float	tickRate;			//snapshots per second, each one a server tick
+			float	clientTick;			//estimate of the server's current tick
+			float	interpolationDelay;	//how many ticks behind clientTick objects are drawn
+			float	maxExtrapolation;	//how many ticks objects keep moving for when states stop arriving
+
+			GameObject* localPlayer;
+
+			int							inputSequence;	//sequence number of the last input sent
+			int							inputRedundancy;
+			std::vector<PlayerInput>	recentInputs;	//newest first, sent again with every input
+			std::vector<PlayerInput>	pendingInputs;	//inputs the server hasn't applied yet
+			int							lastReconciledInput;
+
+			Stats stats;
+		};
+	}
+}
@@ -15,7 +15,6 @@ using namespace NCL;
 using namespace CSC8503;
 
 CourseworkGame::CourseworkGame() : controller(*Window::GetWindow()->GetKeyboard(), *Window::GetWindow()->GetMouse()) {
-	world		= new GameWorld();
 #ifdef USEVULKAN
 	renderer	= new GameTechVulkanRenderer(*world);
 	renderer->Init();
@@ -24,8 +23,6 @@ CourseworkGame::CourseworkGame() : controller(*Window::GetWindow()->GetKeyboard(
 	renderer = new GameTechRenderer(*world);
 #endif
 
-	physics		= new PhysicsSystem(*world);
-
 	forceMagnitude	= 10.0f;
 	useGravity		= true;
 	physics->UseGravity(useGravity);
@@ -85,9 +82,7 @@ CourseworkGame::~CourseworkGame()	{
 	delete basicTex;
 	delete basicShader;
 
-	delete physics;
 	delete renderer;
-	delete world;
 }
 
 void CourseworkGame::UpdateGame(float dt) {
@@ -174,31 +169,6 @@ void CourseworkGame::UpdateOuter(float dt)
 	renderer->Render();
 	Debug::UpdateRenderables(dt);
 }
-void CourseworkGame::UpdatePathFindings(float dt)
-{
-	for (EnemyObject* enemy : enemyObjects)
-	{
-
-		if(enemy->GetStateMachine()) enemy->GetStateMachine()->Update(dt);
-		/*
-		if (enemy->IsNavigationSet())
-		{
-			Vector3 target = playerObject->GetTransform().GetPosition();
-			target.y = 0;
-			//Debug::Print("PlayerPos:" + std::to_string(target.x) + " " + std::to_string(target.y) + " " + std::to_string(target.z) + "\n", Vector2(5, 50));
-			enemy->SetTargetDestination(target);
-			//target = enemy->GetTargetDestination();
-			//Debug::Print("Target:" + std::to_string(target.x) + " " + std::to_string(target.y) + " " + std::to_string(target.z) + "\n", Vector2(5, 60));
-			enemy->FindPath(enemy->GetTargetDestination());
-			enemy->DrawNavigationPath();
-
-			Vector3 direction = (enemy->GetNextPathNode() - enemy->GetTransform().GetPosition()).Normalised();
-			enemy->GetPhysicsObject()->AddForce(direction * 6.0f * dt);
-		}
-		*/
-	}
-}
-
 void CourseworkGame::UpdateKeys() 
 {
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F1)) {
@@ -222,6 +192,18 @@ void CourseworkGame::UpdateKeys()
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F3)) {
 		physics->ToggleDrawHitboxes();
 	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
+		physics->ToggleBroadPhase();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
+		physics->ToggleSimpleContainer();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() - 1);
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() + 1);
+	}
 	
 	//Running certain physics updates in a consistent order might cause some
 	//bias in the calculations - the same objects might keep 'winning' the constraint
@@ -282,7 +264,7 @@ void CourseworkGame::AttachCameraPlayer()
 	
 	Vector3 objPos = playerObject->GetTransform().GetPosition();
 
-	Vector3 camOrientation = playerCameraRotation->ToEuler();
+	Vector3 camOrientation = playerCameraRotation.ToEuler();
 	float pitch = camOrientation.x;
 	float yaw = camOrientation.y;
 
@@ -299,11 +281,11 @@ void CourseworkGame::AttachCameraPlayer()
 		yaw -= 360.0f;
 	}
 
-	*playerCameraRotation = Quaternion::EulerAnglesToQuaternion(pitch, yaw, camOrientation.z);
+	playerCameraRotation = Quaternion::EulerAnglesToQuaternion(pitch, yaw, camOrientation.z);
 	Vector3 offset(0, 4, 0);
 	Vector3 camPos = (
 		Matrix4::Translation(objPos + offset) *
-		Matrix4(*playerCameraRotation) *
+		Matrix4(playerCameraRotation) *
 		Matrix4::Translation(Vector3(0,0,13))
 		).GetPositionVector();
 
@@ -372,6 +354,32 @@ void CourseworkGame::MovePlayerObject(float dt)
 		playerObject->GetPhysicsObject()->AddForce(direction * grappleForce);
 	}
 
+	float spd = 20.0f * dt ;
+
+	Vector3 moveDirection = GetKeyboardMoveDirection();
+	playerObject->GetPhysicsObject()->AddForce(moveDirection * spd);
+	
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F))
+	{
+		playerObject->GetPhysicsObject()->ApplyLinearImpulse(camQuat*Vector3(0,0,-1) * 128.0f * dt);
+	}
+
+	//std::cout << playerGroundedCollider->IsColliding() << "\n";
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::SPACE) && playerGroundedCollider->IsColliding()) {
+		//std::cout << "JUMP\n";
+
+		playerObject->GetPhysicsObject()->ApplyLinearImpulse(Vector3(0, 32.0f, 0) * dt);
+	}
+	playerGroundedCollider->GetPhysicsObject()->SetLinearVelocity(playerObject->GetPhysicsObject()->GetLinearVelocity());
+}
+
+/*
+WASD movement, relative to the way the camera is facing but kept flat
+on the ground. Shared with the networked game, which sends it to the
+server as part of each input.
+*/
+Vector3 CourseworkGame::GetKeyboardMoveDirection() 
+{
 	Matrix4 view = world->GetMainCamera().BuildViewMatrix();
 	Matrix4 camWorld = view.Inverse();
 
@@ -381,15 +389,6 @@ void CourseworkGame::MovePlayerObject(float dt)
 	fwdAxis.y = 0.0f;
 	fwdAxis.Normalise();
 
-	Vector3 fwdAxisCamera = Vector3::Cross(Vector3(0, 1, 0), rightAxis);
-	fwdAxisCamera.Normalise();
-
-	
-
-
-
-	float spd = 20.0f * dt ;
-
 	Vector3 moveDirection = Vector3(0, 0, 0);
 	if (Window::GetKeyboard()->KeyDown(KeyCodes::W)) {
 		moveDirection = (fwdAxis);
@@ -406,20 +405,7 @@ void CourseworkGame::MovePlayerObject(float dt)
 	if (Window::GetKeyboard()->KeyDown(KeyCodes::D)) {
 		moveDirection = (rightAxis);
 	}
-	playerObject->GetPhysicsObject()->AddForce(moveDirection * spd);
-	
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F))
-	{
-		playerObject->GetPhysicsObject()->ApplyLinearImpulse(camQuat*Vector3(0,0,-1) * 128.0f * dt);
-	}
-
-	//std::cout << playerGroundedCollider->IsColliding() << "\n";
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::SPACE) && playerGroundedCollider->IsColliding()) {
-		//std::cout << "JUMP\n";
-
-		playerObject->GetPhysicsObject()->ApplyLinearImpulse(Vector3(0, 32.0f, 0) * dt);
-	}
-	playerGroundedCollider->GetPhysicsObject()->SetLinearVelocity(playerObject->GetPhysicsObject()->GetLinearVelocity());
+	return moveDirection;
 }
 
 void CourseworkGame::DebugObjectMovement() {
@@ -469,310 +455,6 @@ void CourseworkGame::InitCamera() {
 	lockedObject = nullptr;
 }
 
-void CourseworkGame::InitWorld() {
-	world->ClearAndErase();
-	physics->Clear();
-	
-	enemyObjects.clear();
-	playerObject = AddPlayerToWorld(Vector3(20 * 8, 5, 20 * 9));
-	playerObject->SetRespawnPoint(Vector3(20 * 8, 5, 20 * 9));
-	playerGroundedCollider = AddSphereToWorld(playerObject->GetTransform().GetPosition(), 1.0f, 0.1f, LAYER_DEFAULT, false, false);
-	playerGroundedCollider->AddToIgnoreList(playerObject);
-	std::cout << "\n" << playerGroundedCollider->GetObjectIgnoreList().size() << "\n";
-	if (true)
-	{
-		GenerateLevel();
-		for (int i = 0; i < 5; i++)
-		{
-			enemyObjects.push_back(AddEnemyToWorld(Vector3(18 * 20, 10, (1 + i * 3) * 20)));
-		}
-	}
-	else
-	{
-		InitMixedGridWorld(15, 15, 3.5f, 3.5f);
-		BridgeConstraintTest();
-		InitDefaultFloor();
-	}
-	
-}
-
-void CourseworkGame::GenerateLevel()
-{
-	levelData = new LevelData("TestGrid1.txt");
-	int nodeSize = levelData->GetNodeSize();
-	float nodeHeight = nodeSize * 0.25f;
-	for (int i = 0; i < levelData->GetGridSize(); i++)
-	{
-		LevelGridUnit lgu = levelData->GetAllGridUnits()[i];
-		int type = lgu.type;
-		if (isdigit(type))
-		{
-			float unitHeight = nodeHeight * (float(type) - 48);
-			AddCubeToWorld(lgu.position + Vector3(0, unitHeight,0), Vector3(1 * nodeSize / 2, unitHeight, 1 * nodeSize / 2) , 0);
-		}
-	}
-	AddFloorToWorld(Vector3(levelData->GetGridDimentions().x / 2, -0.25, levelData->GetGridDimentions().y / 2) * nodeSize - Vector3(1 * nodeSize / 2, 0, 1 * nodeSize / 2)
-		, Vector3(levelData->GetGridDimentions().x / 2 * nodeSize, 5, levelData->GetGridDimentions().y * nodeSize / 2));
-
-	outOfBounds[0] = -nodeSize / 2;
-	outOfBounds[1] = -nodeSize / 2;
-
-	outOfBounds[2] = levelData->GetGridDimentions().x * nodeSize + nodeSize / 2;
-	outOfBounds[3] = levelData->GetGridDimentions().y * nodeSize + nodeSize / 2;
-}
-
-/*
-
-A single function to add a large immoveable cube to the bottom of our world
-
-*/
-GameObject* CourseworkGame::AddFloorToWorld(const Vector3& position, Vector3 dimensions) {
-	GameObject* floor = new GameObject();
-
-	Vector3 floorSize = dimensions;
-	//AABBVolume* volume = new AABBVolume(floorSize);
-	OBBVolume* volume = new OBBVolume(floorSize);
-	floor->SetBoundingVolume((CollisionVolume*)volume);
-	floor->GetTransform()
-		.SetScale(floorSize * 2)
-		.SetPosition(position)
-		.SetOrientation(Quaternion::EulerAnglesToQuaternion(0,0,0))
-		;
-
-	floor->SetRenderObject(new RenderObject(&floor->GetTransform(), cubeMesh, basicTex, basicShader));
-	floor->SetPhysicsObject(new PhysicsObject(&floor->GetTransform(), floor->GetBoundingVolume()));
-	floor->GetPhysicsObject()->SetElasticity(0.0f);
-	floor->GetPhysicsObject()->SetInverseMass(0);
-	floor->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(floor);
-
-	return floor;
-}
-
-/*
-
-Builds a game object that uses a sphere mesh for its graphics, and a bounding sphere for its
-rigid body representation. This and the cube function will let you build a lot of 'simple' 
-physics worlds. You'll probably need another function for the creation of OBB cubes too.
-
-*/
-GameObject* CourseworkGame::AddSphereToWorld(const Vector3& position, float radius, float inverseMass, int collisionLayer, bool isCollidable, bool rendered) {
-	GameObject* sphere = new GameObject();
-
-	Vector3 sphereSize = Vector3(radius, radius, radius);
-	SphereVolume* volume = new SphereVolume(radius, collisionLayer, isCollidable);
-	
-	sphere->SetBoundingVolume((CollisionVolume*)volume);
-	
-	sphere->GetTransform()
-		.SetScale(sphereSize)
-		.SetPosition(position);
-
-
-	if(rendered) sphere->SetRenderObject(new RenderObject(&sphere->GetTransform(), sphereMesh, basicTex, basicShader));
-	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
-
-	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
-	sphere->GetPhysicsObject()->InitSphereInertia();
-	sphere->GetPhysicsObject()->SetElasticity(1.0f);
-	world->AddGameObject(sphere);
-
-	return sphere;
-}
-
-GameObject* CourseworkGame::AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass, int collisionLayer, bool isCollidable, bool rendered) {
-	GameObject* cube = new GameObject();
-
-	AABBVolume* volume = new AABBVolume(dimensions, collisionLayer, isCollidable);
-	cube->SetBoundingVolume((CollisionVolume*)volume);
-
-	cube->GetTransform()
-		.SetPosition(position)
-		.SetScale(dimensions * 2);
-
-	if (rendered) cube->SetRenderObject(new RenderObject(&cube->GetTransform(), cubeMesh, basicTex, basicShader));
-	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
-
-	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
-	cube->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(cube);
-
-	return cube;
-}
-
-GameObject* CourseworkGame::AddCapsuleToWorld(const Vector3& position, float halfHeight, float radius , float inverseMass, int collisionLayer, bool isCollidable, bool rendered) {
-	GameObject* capsule = new GameObject();
-
-	CapsuleVolume* volume = new CapsuleVolume(halfHeight, radius, collisionLayer, isCollidable);
-	capsule->SetBoundingVolume((CollisionVolume*)volume);
-
-	capsule->GetTransform()
-		.SetPosition(position)
-		.SetScale(Vector3(radius, halfHeight, radius));
-
-	if (rendered) capsule->SetRenderObject(new RenderObject(&capsule->GetTransform(), capsuleMesh, basicTex, basicShader));
-	capsule->SetPhysicsObject(new PhysicsObject(&capsule->GetTransform(), capsule->GetBoundingVolume()));
-
-	capsule->GetPhysicsObject()->SetInverseMass(inverseMass);
-	capsule->GetPhysicsObject()->InitCubeInertia();
-
-	world->AddGameObject(capsule);
-
-	return capsule;
-}
-
-PlayerObject* CourseworkGame::AddPlayerToWorld(const Vector3& position) {
-	float meshSize		= 2.0f;
-	float inverseMass	= 50.0f;
-
-	PlayerObject* character = new PlayerObject();
-	character->SetName("Player");
-	CapsuleVolume* volume  = new CapsuleVolume(meshSize, meshSize, LAYER_PLAYER);
-
-	character->SetBoundingVolume((CollisionVolume*)volume);
-
-	character->GetTransform()
-		.SetScale(Vector3(meshSize, meshSize, meshSize))
-		.SetPosition(position);
-
-	character->SetRenderObject(new RenderObject(&character->GetTransform(), charMesh, nullptr, basicShader));
-	character->SetPhysicsObject(new PhysicsObject(&character->GetTransform(), character->GetBoundingVolume()));
-
-	character->GetPhysicsObject()->SetInverseMass(inverseMass);
-	character->GetPhysicsObject()->InitSphereInertia();
-	character->GetPhysicsObject()->SetElasticity(0.0f);
-	world->AddGameObject(character);
-	playerCameraRotation = new Quaternion(Vector3(0, 0, 0), 0);
-	return character;
-}
-
-EnemyObject* CourseworkGame::AddEnemyToWorld(const Vector3& position) {
-
-	float meshSize = 2.0f;
-	float inverseMass = 50.0f;
-	EnemyObject* character = new EnemyObject(levelData,world, "GenericEnemy");
-	CapsuleVolume* volume = new CapsuleVolume(meshSize, meshSize, LAYER_ENEMY);
-
-	character->SetPlayerObjectTarget(playerObject);
-
-	character->SetBoundingVolume((CollisionVolume*)volume);
-
-	character->GetTransform()
-		.SetScale(Vector3(meshSize, meshSize, meshSize))
-		.SetPosition(position);
-
-	character->SetRenderObject(new RenderObject(&character->GetTransform(), enemyMesh, nullptr, basicShader));
-	character->SetPhysicsObject(new PhysicsObject(&character->GetTransform(), character->GetBoundingVolume()));
-
-	character->GetPhysicsObject()->SetInverseMass(inverseMass);
-	character->GetPhysicsObject()->InitSphereInertia();
-
-	
-
-
-	
-
-	
-	world->AddGameObject(character);
-
-	return character;
-}
-
-GameObject* CourseworkGame::AddBonusToWorld(const Vector3& position) {
-	GameObject* apple = new GameObject();
-
-	SphereVolume* volume = new SphereVolume(0.5f);
-	apple->SetBoundingVolume((CollisionVolume*)volume);
-	apple->GetTransform()
-		.SetScale(Vector3(2, 2, 2))
-		.SetPosition(position);
-
-	apple->SetRenderObject(new RenderObject(&apple->GetTransform(), cubeMesh, nullptr, basicShader));
-	apple->SetPhysicsObject(new PhysicsObject(&apple->GetTransform(), apple->GetBoundingVolume()));
-
-	apple->GetPhysicsObject()->SetInverseMass(1.0f);
-	apple->GetPhysicsObject()->InitSphereInertia();
-
-	world->AddGameObject(apple);
-
-	return apple;
-}
-
-StateGameObject* CourseworkGame::AddStateObjectToWorld(const Vector3& position)
-{
-	StateGameObject* apple = new StateGameObject();
-
-	SphereVolume* volume = new SphereVolume(0.5f);
-	apple->SetBoundingVolume((CollisionVolume*)volume);
-	apple->GetTransform()
-		.SetScale(Vector3(2, 2, 2))
-		.SetPosition(position);
-
-	apple->SetRenderObject(new RenderObject(&apple->GetTransform(), cubeMesh, nullptr, basicShader));
-	apple->SetPhysicsObject(new PhysicsObject(&apple->GetTransform(), apple->GetBoundingVolume()));
-
-	apple->GetPhysicsObject()->SetInverseMass(1.0f);
-	apple->GetPhysicsObject()->InitSphereInertia();
-
-	world->AddGameObject(apple);
-
-	return apple;
-}
-
-void CourseworkGame::InitDefaultFloor() {
-	//AddSphereToWorld(Vector3(50, 25, 0), 1.0f * 10.0f);
-	AddFloorToWorld(Vector3(0, -20, 0), Vector3(200,5,200));
-}
-
-void CourseworkGame::InitGameExamples() {
-	//AddPlayerToWorld(Vector3(0, 5, 0));
-	//AddEnemyToWorld(Vector3(5, 5, 0));
-	//AddBonusToWorld(Vector3(10, 5, 0));
-}
-
-void CourseworkGame::InitSphereGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, float radius) {
-	for (int x = 0; x < numCols; ++x) {
-		for (int z = 0; z < numRows; ++z) {
-			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
-			AddSphereToWorld(position, radius, 1.0f);
-		}
-	}
-	//AddFloorToWorld(Vector3(0, -2, 0));
-}
-
-void CourseworkGame::InitMixedGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing) {
-	float sphereRadius = 1.0f;
-	Vector3 cubeDims = Vector3(1, 1, 1);
-	AddCapsuleToWorld(Vector3(0, 75, 0), sphereRadius * 30.0f, sphereRadius * 30.0f);
-	//AddSphereToWorld(Vector3(50, 25, 0), sphereRadius * 10.0f);
-	//AddCapsuleToWorld(Vector3(0, 0, 0), cubeDims.y * 20, sphereRadius * 20);
-	numRows = 10;
-	for (int x = 0; x < numRows; ++x) {
-		for (int z = 0; z < numRows; ++z) {
-			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
-
-			if (rand() % 2) {
-				AddCubeToWorld(position, cubeDims);
-			}
-			else {
-				AddSphereToWorld(position, sphereRadius);
-				//AddCapsuleToWorld(position, cubeDims.y, sphereRadius);
-			}
-		}
-	}
-}
-
-void CourseworkGame::InitCubeGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, const Vector3& cubeDims) {
-	for (int x = 1; x < numCols+1; ++x) {
-		for (int z = 1; z < numRows+1; ++z) {
-			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
-			AddCubeToWorld(position, cubeDims, 1.0f);
-		}
-	}
-}
-
 /*
 Every frame, this code will let you perform a raycast, to see if there's an object
 underneath the cursor, and if so 'select it' into a pointer, so that it can be 
@@ -860,33 +542,3 @@ void CourseworkGame::MoveSelectedObject() {
 		}
 	}
 }
-
-void CourseworkGame::BridgeConstraintTest() 
-{
-	std::cout << "THE BRIDGE\n";
-	Vector3 cubeSize = Vector3(3, 3, 3);
-	
-	float invCubeMass = 5;
-	int numLinks = 20;
-	float maxDistance = 15; 
-	float cubeDistance = 10; 
-	
-	Vector3 startPos = Vector3(100, 100, 100);
-	
-	GameObject * start = AddCubeToWorld(startPos + Vector3(0, 0, 0), cubeSize, 0);
-	GameObject * end = AddCubeToWorld(startPos + Vector3((numLinks + 2) * cubeDistance, 0, 0), cubeSize, 0);
-	
-	GameObject * previous = start;
-	
-	for (int i = 0; i < numLinks; ++i) 
-	{
-		//Debug::DrawLine(Vector3(0, 0, 0), startPos + Vector3((i + 1) * cubeDistance, 0, 0), Vector4(0, 0, 1, 1),100.0f);
-		GameObject * block = AddCubeToWorld(startPos + Vector3((i + 1) * cubeDistance, 0, 0), cubeSize, invCubeMass);
-		PositionConstraint * constraint = new PositionConstraint(previous, block, maxDistance);
-		world->AddConstraint(constraint);
-		previous = block;
-	}
-	PositionConstraint* constraint = new PositionConstraint(previous, end, maxDistance);
-	world->AddConstraint(constraint);
-	
-}
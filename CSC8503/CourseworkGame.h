@@ -5,7 +5,7 @@
 #ifdef USEVULKAN
 #include "GameTechVulkanRenderer.h"
 #endif
-#include "PhysicsSystem.h"
+#include "GameLevel.h"
 
 #include "StateGameObject.h"
 #include "StateMachine.h"
@@ -15,7 +15,7 @@
 #include <string>
 namespace NCL {
 	namespace CSC8503 {
-		class CourseworkGame {
+		class CourseworkGame : public GameLevel {
 		public:
 			CourseworkGame();
 			~CourseworkGame();
@@ -31,49 +31,19 @@ namespace NCL {
 			void InitCamera();
 			void UpdateKeys();
 
-			void InitWorld();
-
-			/*
-			These are some of the world/object creation functions I created when testing the functionality
-			in the module. Feel free to mess around with them to see different objects being created in different
-			test scenarios (constraints, collision types, and so on). 
-			*/
-			void InitGameExamples();
-
-			void InitSphereGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, float radius);
-			void InitMixedGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing);
-			void InitCubeGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, const Vector3& cubeDims);
-			void BridgeConstraintTest();
-
-			void InitDefaultFloor();
-
 			bool SelectObject();
 			void MoveSelectedObject();
 			void DebugObjectMovement();
 			void LockedObjectMovement();
 			void AttachCameraPlayer();
-			void MovePlayerObject(float dt);
-			void GenerateLevel();
-			void UpdatePathFindings(float dt);
-
-
-			GameObject* AddFloorToWorld(const Vector3& position, Vector3 dimensions);
-			GameObject* AddSphereToWorld(const Vector3& position, float radius, float inverseMass = 10.0f, int collisionLayer = LAYER_DEFAULT, bool isCollidable = true, bool rendered = true);
-			GameObject* AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f, int collisionLayer = LAYER_DEFAULT, bool isCollidable = true, bool rendered = true);
-			GameObject* AddCapsuleToWorld(const Vector3& position, float halfHeight, float radius, float inverseMass = 10.0f, int collisionLayer = LAYER_DEFAULT, bool isCollidable = true, bool rendered = true);
-
-			PlayerObject* AddPlayerToWorld(const Vector3& position);
-			EnemyObject* AddEnemyToWorld(const Vector3& position);
-			GameObject* AddBonusToWorld(const Vector3& position);
+			virtual void MovePlayerObject(float dt);
+			Vector3 GetKeyboardMoveDirection();
 
 #ifdef USEVULKAN
 			GameTechVulkanRenderer*	renderer;
 #else
 			GameTechRenderer* renderer;
 #endif
-			PhysicsSystem*		physics;
-			GameWorld*			world;
-
 			KeyboardMouseController controller;
 
 			bool useGravity;
@@ -83,18 +53,6 @@ namespace NCL {
 
 			GameObject* selectionObject = nullptr;
 
-			Mesh*	capsuleMesh = nullptr;
-			Mesh*	cubeMesh	= nullptr;
-			Mesh*	sphereMesh	= nullptr;
-
-			Texture*	basicTex	= nullptr;
-			Shader*		basicShader = nullptr;
-
-			//Coursework Meshes
-			Mesh*	charMesh	= nullptr;
-			Mesh*	enemyMesh	= nullptr;
-			Mesh*	bonusMesh	= nullptr;
-
 			//Coursework Additional functionality	
 			GameObject* lockedObject	= nullptr;
 			Vector3 lockedOffset		= Vector3(0, 0, 0);
@@ -104,16 +62,7 @@ namespace NCL {
 
 			GameObject* objClosest = nullptr;
 
-			StateGameObject* AddStateObjectToWorld(const Vector3& position);
-			StateGameObject* testStateObject;
-
-			PlayerObject* playerObject = nullptr;
-			GameObject* playerGroundedCollider = nullptr;
 			Controller* playerController = nullptr;
-			Quaternion* playerCameraRotation;
-			LevelData* levelData = nullptr;
-			float outOfBounds[4] = {};
-			std::vector<EnemyObject*> enemyObjects = std::vector<EnemyObject*>{};
 		};
 	
 	
@@ -0,0 +1,484 @@
+#include "GameLevel.h"
+#include "GameWorld.h"
+#include "PhysicsObject.h"
+#include "RenderObject.h"
+#include "NetworkObject.h"
+
+#include "PositionConstraint.h"
+#include "OrientationConstraint.h"
+#include "StateGameObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+GameLevel::GameLevel() {
+	world	= new GameWorld();
+	physics	= new PhysicsSystem(*world);
+}
+
+//The world doesn't delete its objects on its own, and a headless server opens and closes levels all the time
+GameLevel::~GameLevel() {
+	delete physics;
+	world->ClearAndErase();
+	delete world;
+	delete levelData; //after the enemies using it have gone with the world
+}
+
+/*
+Runs everything the level needs each frame, other than drawing it. The
+windowed game does the same, with the renderer's update slotted in.
+*/
+void GameLevel::UpdateSimulation(float dt) {
+	UpdatePathFindings(dt);
+	world->UpdateWorld(dt);
+	physics->Update(dt);
+}
+
+/*
+Every end of a connection builds the same level, so handing out network IDs
+in world ID order gives each object the same ID everywhere.
+*/
+void GameLevel::InitNetworkObjects() {
+	std::vector<GameObject*> newObjects;
+	world->OperateOnContents([&](GameObject* o) {
+		if (o->GetPhysicsObject() && !o->GetNetworkObject()) {
+			newObjects.emplace_back(o);
+		}
+	});
+	std::sort(newObjects.begin(), newObjects.end(),
+		[](const GameObject* a, const GameObject* b) { return a->GetWorldID() < b->GetWorldID(); });
+
+	for (GameObject* o : newObjects) {
+		int networkID = networkIDs.Allocate(0);
+		NetworkObject* n = new NetworkObject(*o, networkID);
+		o->SetNetworkObject(n);
+		if (networkID >= (int)networkObjects.size()) {
+			networkObjects.resize(networkID + 1, nullptr);
+		}
+		networkObjects[networkID] = n;
+	}
+}
+
+/*
+Anything already using the network ID is replaced - clients are always
+told about a despawn before the ID is spawned again, but the level can't
+be left holding two objects under one ID if it somehow isn't.
+*/
+NetworkObject* GameLevel::SpawnNetworkObject(int prefab, int networkID, const Vector3& position) {
+	if (networkID < 0) {
+		return nullptr;
+	}
+	GameObject* o = nullptr;
+	switch (prefab) {
+		case Prefab_Player: {
+			PlayerObject* player = AddPlayerToWorld(position);
+			player->SetRespawnPoint(position);
+			o = player;
+		}break;
+		case Prefab_Sphere:	o = AddSphereToWorld(position, 1.0f);					break;
+		case Prefab_Cube:	o = AddCubeToWorld(position, Vector3(1, 1, 1));			break;
+		case Prefab_Bonus:	o = AddBonusToWorld(position);							break;
+		default:			return nullptr;
+	}
+	if (networkID < (int)networkObjects.size() && networkObjects[networkID]) {
+		DespawnNetworkObject(networkID);
+	}
+	if (networkID >= (int)networkObjects.size()) {
+		networkObjects.resize(networkID + 1, nullptr);
+	}
+	NetworkObject* n = new NetworkObject(*o, networkID);
+	o->SetNetworkObject(n);
+	networkObjects[networkID] = n;
+	return n;
+}
+
+void GameLevel::DespawnNetworkObject(int networkID) {
+	if (networkID < 0 || networkID >= (int)networkObjects.size() || !networkObjects[networkID]) {
+		return;
+	}
+	NetworkObject* n	= networkObjects[networkID];
+	GameObject& o		= n->GetGameObject();
+	networkObjects[networkID] = nullptr;
+
+	//Taken off the network straight away, rather than whenever the world next updates
+	o.SetNetworkObject(nullptr);
+	delete n;
+	world->RemoveGameObject(&o, true);
+}
+
+//Around the level's own player, a few units apart so nobody spawns inside anyone else
+Vector3 GameLevel::GetPlayerSpawnPoint(int playerNum) const {
+	Vector3 origin = playerObject ? playerObject->GetRespawnPoint() : Vector3();
+	return origin + Vector3(4.0f * (1 + playerNum % 4), 0.0f, 4.0f * (playerNum / 4 % 4));
+}
+
+//Positions are quantised over the level, with a little room either side
+StateQuantisation GameLevel::GetNetworkQuantisation() const {
+	StateQuantisation q;
+	q.boundsMin = Vector3(outOfBounds[0], -64.0f, outOfBounds[1]) - Vector3(64.0f, 0.0f, 64.0f);
+	q.boundsMax = Vector3(outOfBounds[2], 192.0f, outOfBounds[3]) + Vector3(64.0f, 0.0f, 64.0f);
+	return q;
+}
+
+void GameLevel::InitWorld() {
+	world->ClearAndErase();
+	physics->Clear();
+	networkObjects.clear(); //deleted along with their game objects
+	networkIDs.Clear();
+	
+	enemyObjects.clear();
+	playerObject = AddPlayerToWorld(Vector3(20 * 8, 5, 20 * 9));
+	playerObject->SetRespawnPoint(Vector3(20 * 8, 5, 20 * 9));
+	playerCameraRotation = Quaternion(Vector3(0, 0, 0), 0);
+	playerGroundedCollider = AddSphereToWorld(playerObject->GetTransform().GetPosition(), 1.0f, 0.1f, LAYER_DEFAULT, false, false);
+	playerGroundedCollider->AddToIgnoreList(playerObject);
+	if (true)
+	{
+		GenerateLevel();
+		for (int i = 0; i < 5; i++)
+		{
+			enemyObjects.push_back(AddEnemyToWorld(Vector3(18 * 20, 10, (1 + i * 3) * 20)));
+		}
+	}
+	else
+	{
+		InitMixedGridWorld(15, 15, 3.5f, 3.5f);
+		BridgeConstraintTest();
+		InitDefaultFloor();
+	}
+	world->SyncPendingChanges();
+}
+
+void GameLevel::GenerateLevel()
+{
+	delete levelData;
+	levelData = new LevelData("TestGrid1.txt");
+	int nodeSize = levelData->GetNodeSize();
+	float nodeHeight = nodeSize * 0.25f;
+	for (int i = 0; i < levelData->GetGridSize(); i++)
+	{
+		LevelGridUnit lgu = levelData->GetAllGridUnits()[i];
+		int type = lgu.type;
+		if (isdigit(type))
+		{
+			float unitHeight = nodeHeight * (float(type) - 48);
+			AddCubeToWorld(lgu.position + Vector3(0, unitHeight,0), Vector3(1 * nodeSize / 2, unitHeight, 1 * nodeSize / 2) , 0);
+		}
+	}
+	AddFloorToWorld(Vector3(levelData->GetGridDimentions().x / 2, -0.25, levelData->GetGridDimentions().y / 2) * nodeSize - Vector3(1 * nodeSize / 2, 0, 1 * nodeSize / 2)
+		, Vector3(levelData->GetGridDimentions().x / 2 * nodeSize, 5, levelData->GetGridDimentions().y * nodeSize / 2));
+
+	outOfBounds[0] = -nodeSize / 2;
+	outOfBounds[1] = -nodeSize / 2;
+
+	outOfBounds[2] = levelData->GetGridDimentions().x * nodeSize + nodeSize / 2;
+	outOfBounds[3] = levelData->GetGridDimentions().y * nodeSize + nodeSize / 2;
+}
+
+/*
+
+A single function to add a large immoveable cube to the bottom of our world
+
+*/
+GameObject* GameLevel::AddFloorToWorld(const Vector3& position, Vector3 dimensions) {
+	GameObject* floor = new GameObject();
+
+	Vector3 floorSize = dimensions;
+	//AABBVolume* volume = new AABBVolume(floorSize);
+	OBBVolume* volume = new OBBVolume(floorSize);
+	floor->SetBoundingVolume((CollisionVolume*)volume);
+	floor->GetTransform()
+		.SetScale(floorSize * 2)
+		.SetPosition(position)
+		.SetOrientation(Quaternion::EulerAnglesToQuaternion(0,0,0))
+		;
+
+	floor->SetRenderObject(new RenderObject(&floor->GetTransform(), cubeMesh, basicTex, basicShader));
+	floor->SetPhysicsObject(new PhysicsObject(&floor->GetTransform(), floor->GetBoundingVolume()));
+	floor->GetPhysicsObject()->SetElasticity(0.0f);
+	floor->GetPhysicsObject()->SetInverseMass(0);
+	floor->GetPhysicsObject()->InitCubeInertia();
+
+	world->AddGameObject(floor);
+
+	return floor;
+}
+
+/*
+
+Builds a game object that uses a sphere mesh for its graphics, and a bounding sphere for its
+rigid body representation. This and the cube function will let you build a lot of 'simple' 
+physics worlds. You'll probably need another function for the creation of OBB cubes too.
+
+*/
+GameObject* GameLevel::AddSphereToWorld(const Vector3& position, float radius, float inverseMass, int collisionLayer, bool isCollidable, bool rendered) {
+	GameObject* sphere = new GameObject();
+
+	Vector3 sphereSize = Vector3(radius, radius, radius);
+	SphereVolume* volume = new SphereVolume(radius, collisionLayer, isCollidable);
+	
+	sphere->SetBoundingVolume((CollisionVolume*)volume);
+	
+	sphere->GetTransform()
+		.SetScale(sphereSize)
+		.SetPosition(position);
+
+
+	if(rendered) sphere->SetRenderObject(new RenderObject(&sphere->GetTransform(), sphereMesh, basicTex, basicShader));
+	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+
+	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+	sphere->GetPhysicsObject()->InitSphereInertia();
+	sphere->GetPhysicsObject()->SetElasticity(1.0f);
+	world->AddGameObject(sphere);
+
+	return sphere;
+}
+
+GameObject* GameLevel::AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass, int collisionLayer, bool isCollidable, bool rendered) {
+	GameObject* cube = new GameObject();
+
+	AABBVolume* volume = new AABBVolume(dimensions, collisionLayer, isCollidable);
+	cube->SetBoundingVolume((CollisionVolume*)volume);
+
+	cube->GetTransform()
+		.SetPosition(position)
+		.SetScale(dimensions * 2);
+
+	if (rendered) cube->SetRenderObject(new RenderObject(&cube->GetTransform(), cubeMesh, basicTex, basicShader));
+	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+
+	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+	cube->GetPhysicsObject()->InitCubeInertia();
+
+	world->AddGameObject(cube);
+
+	return cube;
+}
+
+GameObject* GameLevel::AddCapsuleToWorld(const Vector3& position, float halfHeight, float radius , float inverseMass, int collisionLayer, bool isCollidable, bool rendered) {
+	GameObject* capsule = new GameObject();
+
+	CapsuleVolume* volume = new CapsuleVolume(halfHeight, radius, collisionLayer, isCollidable);
+	capsule->SetBoundingVolume((CollisionVolume*)volume);
+
+	capsule->GetTransform()
+		.SetPosition(position)
+		.SetScale(Vector3(radius, halfHeight, radius));
+
+	if (rendered) capsule->SetRenderObject(new RenderObject(&capsule->GetTransform(), capsuleMesh, basicTex, basicShader));
+	capsule->SetPhysicsObject(new PhysicsObject(&capsule->GetTransform(), capsule->GetBoundingVolume()));
+
+	capsule->GetPhysicsObject()->SetInverseMass(inverseMass);
+	capsule->GetPhysicsObject()->InitCubeInertia();
+
+	world->AddGameObject(capsule);
+
+	return capsule;
+}
+
+PlayerObject* GameLevel::AddPlayerToWorld(const Vector3& position) {
+	float meshSize		= 2.0f;
+	float inverseMass	= 50.0f;
+
+	PlayerObject* character = new PlayerObject();
+	character->SetName("Player");
+	CapsuleVolume* volume  = new CapsuleVolume(meshSize, meshSize, LAYER_PLAYER);
+
+	character->SetBoundingVolume((CollisionVolume*)volume);
+
+	character->GetTransform()
+		.SetScale(Vector3(meshSize, meshSize, meshSize))
+		.SetPosition(position);
+
+	character->SetRenderObject(new RenderObject(&character->GetTransform(), charMesh, nullptr, basicShader));
+	character->SetPhysicsObject(new PhysicsObject(&character->GetTransform(), character->GetBoundingVolume()));
+
+	character->GetPhysicsObject()->SetInverseMass(inverseMass);
+	character->GetPhysicsObject()->InitSphereInertia();
+	character->GetPhysicsObject()->SetElasticity(0.0f);
+	world->AddGameObject(character);
+	return character;
+}
+
+EnemyObject* GameLevel::AddEnemyToWorld(const Vector3& position) {
+
+	float meshSize = 2.0f;
+	float inverseMass = 50.0f;
+	EnemyObject* character = new EnemyObject(levelData,world, "GenericEnemy");
+	CapsuleVolume* volume = new CapsuleVolume(meshSize, meshSize, LAYER_ENEMY);
+
+	character->SetPlayerObjectTarget(playerObject);
+
+	character->SetBoundingVolume((CollisionVolume*)volume);
+
+	character->GetTransform()
+		.SetScale(Vector3(meshSize, meshSize, meshSize))
+		.SetPosition(position);
+
+	character->SetRenderObject(new RenderObject(&character->GetTransform(), enemyMesh, nullptr, basicShader));
+	character->SetPhysicsObject(new PhysicsObject(&character->GetTransform(), character->GetBoundingVolume()));
+
+	character->GetPhysicsObject()->SetInverseMass(inverseMass);
+	character->GetPhysicsObject()->InitSphereInertia();
+
+	
+
+
+	
+
+	
+	world->AddGameObject(character);
+
+	return character;
+}
+
+GameObject* GameLevel::AddBonusToWorld(const Vector3& position) {
+	GameObject* apple = new GameObject();
+
+	SphereVolume* volume = new SphereVolume(0.5f);
+	apple->SetBoundingVolume((CollisionVolume*)volume);
+	apple->GetTransform()
+		.SetScale(Vector3(2, 2, 2))
+		.SetPosition(position);
+
+	apple->SetRenderObject(new RenderObject(&apple->GetTransform(), cubeMesh, nullptr, basicShader));
+	apple->SetPhysicsObject(new PhysicsObject(&apple->GetTransform(), apple->GetBoundingVolume()));
+
+	apple->GetPhysicsObject()->SetInverseMass(1.0f);
+	apple->GetPhysicsObject()->InitSphereInertia();
+
+	world->AddGameObject(apple);
+
+	return apple;
+}
+
+StateGameObject* GameLevel::AddStateObjectToWorld(const Vector3& position)
+{
+	StateGameObject* apple = new StateGameObject();
+
+	SphereVolume* volume = new SphereVolume(0.5f);
+	apple->SetBoundingVolume((CollisionVolume*)volume);
+	apple->GetTransform()
+		.SetScale(Vector3(2, 2, 2))
+		.SetPosition(position);
+
+	apple->SetRenderObject(new RenderObject(&apple->GetTransform(), cubeMesh, nullptr, basicShader));
+	apple->SetPhysicsObject(new PhysicsObject(&apple->GetTransform(), apple->GetBoundingVolume()));
+
+	apple->GetPhysicsObject()->SetInverseMass(1.0f);
+	apple->GetPhysicsObject()->InitSphereInertia();
+
+	world->AddGameObject(apple);
+
+	return apple;
+}
+
+void GameLevel::InitDefaultFloor() {
+	//AddSphereToWorld(Vector3(50, 25, 0), 1.0f * 10.0f);
+	AddFloorToWorld(Vector3(0, -20, 0), Vector3(200,5,200));
+}
+
+void GameLevel::InitGameExamples() {
+	//AddPlayerToWorld(Vector3(0, 5, 0));
+	//AddEnemyToWorld(Vector3(5, 5, 0));
+	//AddBonusToWorld(Vector3(10, 5, 0));
+}
+
+void GameLevel::InitSphereGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, float radius) {
+	for (int x = 0; x < numCols; ++x) {
+		for (int z = 0; z < numRows; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+			AddSphereToWorld(position, radius, 1.0f);
+		}
+	}
+	//AddFloorToWorld(Vector3(0, -2, 0));
+}
+
+void GameLevel::InitMixedGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing) {
+	float sphereRadius = 1.0f;
+	Vector3 cubeDims = Vector3(1, 1, 1);
+	AddCapsuleToWorld(Vector3(0, 75, 0), sphereRadius * 30.0f, sphereRadius * 30.0f);
+	//AddSphereToWorld(Vector3(50, 25, 0), sphereRadius * 10.0f);
+	//AddCapsuleToWorld(Vector3(0, 0, 0), cubeDims.y * 20, sphereRadius * 20);
+	numRows = 10;
+	for (int x = 0; x < numRows; ++x) {
+		for (int z = 0; z < numRows; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+
+			if (rand() % 2) {
+				AddCubeToWorld(position, cubeDims);
+			}
+			else {
+				AddSphereToWorld(position, sphereRadius);
+				//AddCapsuleToWorld(position, cubeDims.y, sphereRadius);
+			}
+		}
+	}
+}
+
+void GameLevel::InitCubeGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, const Vector3& cubeDims) {
+	for (int x = 1; x < numCols+1; ++x) {
+		for (int z = 1; z < numRows+1; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+			AddCubeToWorld(position, cubeDims, 1.0f);
+		}
+	}
+}
+
+void GameLevel::UpdatePathFindings(float dt)
+{
+	//Only StateGameObjects flag themselves as AI agents
+	world->OperateOnAIContents([&](GameObject* o) {
+		static_cast<StateGameObject*>(o)->Update(dt);
+	});
+	for (EnemyObject* enemy : enemyObjects)
+	{
+		/*
+		if (enemy->IsNavigationSet())
+		{
+			Vector3 target = playerObject->GetTransform().GetPosition();
+			target.y = 0;
+			//Debug::Print("PlayerPos:" + std::to_string(target.x) + " " + std::to_string(target.y) + " " + std::to_string(target.z) + "\n", Vector2(5, 50));
+			enemy->SetTargetDestination(target);
+			//target = enemy->GetTargetDestination();
+			//Debug::Print("Target:" + std::to_string(target.x) + " " + std::to_string(target.y) + " " + std::to_string(target.z) + "\n", Vector2(5, 60));
+			enemy->FindPath(enemy->GetTargetDestination());
+			enemy->DrawNavigationPath();
+
+			Vector3 direction = (enemy->GetNextPathNode() - enemy->GetTransform().GetPosition()).Normalised();
+			enemy->GetPhysicsObject()->AddForce(direction * 6.0f * dt);
+		}
+		*/
+	}
+}
+
+
+void GameLevel::BridgeConstraintTest() 
+{
+	Vector3 cubeSize = Vector3(3, 3, 3);
+	
+	float invCubeMass = 5;
+	int numLinks = 20;
+	float maxDistance = 15; 
+	float cubeDistance = 10; 
+	
+	Vector3 startPos = Vector3(100, 100, 100);
+	
+	GameObject * start = AddCubeToWorld(startPos + Vector3(0, 0, 0), cubeSize, 0);
+	GameObject * end = AddCubeToWorld(startPos + Vector3((numLinks + 2) * cubeDistance, 0, 0), cubeSize, 0);
+	
+	GameObject * previous = start;
+	
+	for (int i = 0; i < numLinks; ++i) 
+	{
+		//Debug::DrawLine(Vector3(0, 0, 0), startPos + Vector3((i + 1) * cubeDistance, 0, 0), Vector4(0, 0, 1, 1),100.0f);
+		GameObject * block = AddCubeToWorld(startPos + Vector3((i + 1) * cubeDistance, 0, 0), cubeSize, invCubeMass);
+		PositionConstraint * constraint = new PositionConstraint(previous, block, maxDistance);
+		world->AddConstraint(constraint);
+		previous = block;
+	}
+	PositionConstraint* constraint = new PositionConstraint(previous, end, maxDistance);
+	world->AddConstraint(constraint);
+	
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "PhysicsSystem.h"
+#include "RenderObject.h"
+#include "NetworkState.h"
+#include "NetworkIDPool.h"
+
+#include "StateGameObject.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class NetworkObject;
+
+		//What a networked object can be created as while the game is running
+		enum NetworkPrefab {
+			Prefab_Player,
+			Prefab_Sphere,
+			Prefab_Cube,
+			Prefab_Bonus,
+			PrefabCount
+		};
+
+		/*
+		The coursework level and everything in it, with nothing that needs a
+		window or a GPU. The windowed game loads meshes etc into the pointers
+		below before building the level - a headless server leaves them null,
+		and gets exactly the same objects, just with nothing to draw them.
+		*/
+		class GameLevel {
+		public:
+			GameLevel();
+			virtual ~GameLevel();
+
+			GameWorld& GetWorld() const {
+				return *world;
+			}
+			PhysicsSystem& GetPhysics() const {
+				return *physics;
+			}
+
+			void InitWorld();
+			void UpdateSimulation(float dt);
+
+			//Networked objects, in the same order at every end of the connection
+			void InitNetworkObjects();
+			//Indexed by network ID - null where an ID isn't in use
+			const std::vector<NetworkObject*>& GetNetworkObjects() const {
+				return networkObjects;
+			}
+			StateQuantisation GetNetworkQuantisation() const;
+
+			//Networked objects created once the level is running. The server takes the network
+			//ID from GetNetworkIDs, and tells clients which one it took. Null for an unknown prefab.
+			NetworkObject*	SpawnNetworkObject(int prefab, int networkID, const Vector3& position = Vector3());
+			//The object is taken out of the world and deleted once the world next updates
+			void			DespawnNetworkObject(int networkID);
+			NetworkIDPool&	GetNetworkIDs() {
+				return networkIDs;
+			}
+
+			Vector3 GetPlayerSpawnPoint(int playerNum) const;
+
+		protected:
+			/*
+			These are some of the world/object creation functions I created when testing the functionality
+			in the module. Feel free to mess around with them to see different objects being created in different
+			test scenarios (constraints, collision types, and so on).
+			*/
+			void InitGameExamples();
+
+			void InitSphereGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, float radius);
+			void InitMixedGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing);
+			void InitCubeGridWorld(int numRows, int numCols, float rowSpacing, float colSpacing, const Vector3& cubeDims);
+			void BridgeConstraintTest();
+
+			void InitDefaultFloor();
+
+			void GenerateLevel();
+			void UpdatePathFindings(float dt);
+
+			GameObject* AddFloorToWorld(const Vector3& position, Vector3 dimensions);
+			GameObject* AddSphereToWorld(const Vector3& position, float radius, float inverseMass = 10.0f, int collisionLayer = LAYER_DEFAULT, bool isCollidable = true, bool rendered = true);
+			GameObject* AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f, int collisionLayer = LAYER_DEFAULT, bool isCollidable = true, bool rendered = true);
+			GameObject* AddCapsuleToWorld(const Vector3& position, float halfHeight, float radius, float inverseMass = 10.0f, int collisionLayer = LAYER_DEFAULT, bool isCollidable = true, bool rendered = true);
+
+			PlayerObject* AddPlayerToWorld(const Vector3& position);
+			EnemyObject* AddEnemyToWorld(const Vector3& position);
+			GameObject* AddBonusToWorld(const Vector3& position);
+
+			StateGameObject* AddStateObjectToWorld(const Vector3& position);
+
+			PhysicsSystem*		physics;
+			GameWorld*			world;
+
+			Mesh*	capsuleMesh = nullptr;
+			Mesh*	cubeMesh	= nullptr;
+			Mesh*	sphereMesh	= nullptr;
+
+			Texture*	basicTex	= nullptr;
+			Shader*		basicShader = nullptr;
+
+			//Coursework Meshes
+			Mesh*	charMesh	= nullptr;
+			Mesh*	enemyMesh	= nullptr;
+			Mesh*	bonusMesh	= nullptr;
+
+			StateGameObject* testStateObject = nullptr;
+
+			PlayerObject* playerObject = nullptr;
+			GameObject* playerGroundedCollider = nullptr;
+			Quaternion playerCameraRotation;
+			LevelData* levelData = nullptr;	//owned - the enemies only borrow it
+			float outOfBounds[4] = {};
+			std::vector<EnemyObject*> enemyObjects = std::vector<EnemyObject*>{};
+
+			std::vector<NetworkObject*> networkObjects;
+			NetworkIDPool				networkIDs;
+		};
+	}
+}
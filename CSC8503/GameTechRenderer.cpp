@@ -133,14 +133,9 @@ void GameTechRenderer::RenderFrame() {
 void GameTechRenderer::BuildObjectList() {
 	activeObjects.clear();
 
-	gameWorld.OperateOnContents(
+	gameWorld.OperateOnRenderContents(
 		[&](GameObject* o) {
-			if (o->IsActive()) {
-				const RenderObject* g = o->GetRenderObject();
-				if (g) {
-					activeObjects.emplace_back(g);
-				}
-			}
+			activeObjects.emplace_back(o->GetRenderObject());
 		}
 	);
 }
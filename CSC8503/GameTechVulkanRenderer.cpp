@@ -357,29 +357,25 @@ void GameTechVulkanRenderer::UpdateObjectList() {
 
 	VulkanMesh* pipeMesh = nullptr;
 	int at = 0;
-	gameWorld.OperateOnContents(
+	gameWorld.OperateOnRenderContents(
 		[&](GameObject* o) {
-			if (o->IsActive()) {
-				RenderObject* g = o->GetRenderObject();
-				if (g) {
-					activeObjects.emplace_back(g);
-
-					ObjectState state;
-					state.modelMatrix = g->GetTransform()->GetMatrix();
-					state.colour = g->GetColour();
-					state.index[0] = 0;
-					if (g->GetMesh()) {
-						pipeMesh = (VulkanMesh*)g->GetMesh();
-					}
-					if (g->GetDefaultTexture()) {
-						VulkanTexture* t = (VulkanTexture*)g->GetDefaultTexture();
-						state.index[0] = t->GetAssetID();
-					}
-					currentFrame->WriteData<ObjectState>(state);
-					currentFrame->debugLinesOffset += sizeof(ObjectState);
-					at++;
-				}
+			RenderObject* g = o->GetRenderObject();
+			activeObjects.emplace_back(g);
+
+			ObjectState state;
+			state.modelMatrix = g->GetTransform()->GetMatrix();
+			state.colour = g->GetColour();
+			state.index[0] = 0;
+			if (g->GetMesh()) {
+				pipeMesh = (VulkanMesh*)g->GetMesh();
+			}
+			if (g->GetDefaultTexture()) {
+				VulkanTexture* t = (VulkanTexture*)g->GetDefaultTexture();
+				state.index[0] = t->GetAssetID();
 			}
+			currentFrame->WriteData<ObjectState>(state);
+			currentFrame->debugLinesOffset += sizeof(ObjectState);
+			at++;
 		}
 	);
 	if (pipeMesh && !scenePipeline.pipeline) {
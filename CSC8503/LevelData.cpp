@@ -13,6 +13,11 @@ LevelData::LevelData()
 	gridHeight = 0;
 	allGridUnits = nullptr;
 }
+LevelData::~LevelData()
+{
+	delete[] allGridUnits;
+}
+
 LevelData::LevelData(const std::string& filename) : LevelData()
 {
 	std::ifstream infile(Assets::DATADIR + filename);
@@ -28,6 +28,7 @@ namespace NCL
 		public:
 			LevelData();
 			LevelData(const std::string& filename);
+			~LevelData();
 			LevelGridUnit* GetAllGridUnits() { return allGridUnits; }
 			int GetGridSize() { return gridWidth * gridHeight; }
 			int GetNodeSize() { return nodeSize; }
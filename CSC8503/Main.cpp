@@ -9,6 +9,10 @@
 #include "GameServer.h"
 #include "GameClient.h"
 
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+
 #include "NavigationGrid.h"
 #include "NavigationMesh.h"
 
@@ -283,6 +287,68 @@ void TestNetworking()
 	//*/
 }
 /*
+Times a per-frame style sweep over a large world, once through the
+std::function based OperateOnContents, and once through the templated
+visitors, so the cost of the type erasure can be seen.
+*/
+void TestWorldIteration()
+{
+	const int objectCount	= 100000;
+	const int sweepCount	= 100;
+
+	GameWorld world;
+	for (int i = 0; i < objectCount; ++i)
+	{
+		GameObject* o = new GameObject();
+		if (i % 2 == 0)
+		{
+			o->SetPhysicsObject(new PhysicsObject(&o->GetTransform(), nullptr));
+		}
+		world.AddGameObject(o);
+	}
+	world.SyncPendingChanges();
+
+	GameTimer t;
+	GameObjectFunc erasedFunc = [](GameObject* o) { o->SetColliding(!o->IsColliding()); };
+	for (int i = 0; i < sweepCount; ++i)
+	{
+		world.OperateOnContents(erasedFunc);
+	}
+	t.Tick();
+	float erasedTime = t.GetTimeDeltaMSec();
+
+	for (int i = 0; i < sweepCount; ++i)
+	{
+		world.OperateOnContents([](GameObject* o) { o->SetColliding(!o->IsColliding()); });
+	}
+	t.Tick();
+	float templatedTime = t.GetTimeDeltaMSec();
+
+	for (int i = 0; i < sweepCount; ++i)
+	{
+		world.OperateOnContents([](GameObject* o) {
+			if (o->GetPhysicsObject()) o->GetPhysicsObject()->ClearForces();
+		});
+	}
+	t.Tick();
+	float checkedTime = t.GetTimeDeltaMSec();
+
+	for (int i = 0; i < sweepCount; ++i)
+	{
+		world.OperateOnPhysicsContents([](GameObject* o) { o->GetPhysicsObject()->ClearForces(); });
+	}
+	t.Tick();
+	float filteredTime = t.GetTimeDeltaMSec();
+
+	std::cout << objectCount << " objects, " << sweepCount << " sweeps\n";
+	std::cout << "std::function visitor: " << erasedTime	<< "ms\n";
+	std::cout << "Templated visitor: "		<< templatedTime	<< "ms\n";
+	std::cout << "Physics sweep, checked: "	<< checkedTime	<< "ms\n";
+	std::cout << "Physics sweep, filtered: " << filteredTime	<< "ms\n";
+
+	world.ClearAndErase();
+}
+/*
 
 The main function should look pretty familar to you!
 We make a window, and then go into a while loop that repeatedly
@@ -303,6 +369,7 @@ int main() {
 	
 
 	//TestNetworking();
+	//TestWorldIteration();
 	//TestBehaviourTree();
 	//TestPushdownAutomata(w);
 	//TestStateMachine();
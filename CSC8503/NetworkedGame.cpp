@@ -3,6 +3,8 @@
 #include "NetworkObject.h"
 #include "GameServer.h"
 #include "GameClient.h"
+#include "NetworkStats.h"
+#include "PhysicsObject.h"
 
 #define COLLISION_MSG 30
 
@@ -19,21 +21,32 @@ struct MessagePacket : public GamePacket {
 NetworkedGame::NetworkedGame()	{
 	thisServer = nullptr;
 	thisClient = nullptr;
+	serverGame = nullptr;
+	clientGame = nullptr;
+	levelPlayer = nullptr;
 
 	NetworkBase::Initialise();
-	timeToNextPacket  = 0.0f;
-	packetsToSnapshot = 0;
+	timeToNextPacket		= 0.0f;
+	networkTickRate			= 20.0f;
+	inputButtons			= 0;
+
+	statsLogTime			= 0.0f;
+	statsLogTimer			= 0.0f;
 }
 
 NetworkedGame::~NetworkedGame()	{
+	delete serverGame;
+	delete clientGame;
 	delete thisServer;
 	delete thisClient;
 }
 
 void NetworkedGame::StartAsServer() {
 	thisServer = new GameServer(NetworkBase::GetDefaultPort(), 4);
-
-	thisServer->RegisterPacketHandler(Received_State, this);
+	serverGame = new ServerGame(*this, *thisServer, networkTickRate);
+	serverGame->RegisterPacketHandlers();
+	serverGame->SetSnapshotThread(true);
+	serverGame->SetSnapshotCompression(true);
 
 	StartLevel();
 }
@@ -42,15 +55,28 @@ void NetworkedGame::StartAsClient(char a, char b, char c, char d) {
 	thisClient = new GameClient();
 	thisClient->Connect(a, b, c, d, NetworkBase::GetDefaultPort());
 
-	thisClient->RegisterPacketHandler(Delta_State, this);
-	thisClient->RegisterPacketHandler(Full_State, this);
-	thisClient->RegisterPacketHandler(Player_Connected, this);
-	thisClient->RegisterPacketHandler(Player_Disconnected, this);
+	clientGame = new ClientGame(*this, *thisClient, networkTickRate);
+	clientGame->RegisterPacketHandlers();
 
 	StartLevel();
 }
 
 void NetworkedGame::UpdateGame(float dt) {
+	if (thisClient) {
+		//Inputs only go out once a tick, so hang on to any presses in between
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::SPACE)) {
+			inputButtons |= PlayerInput::Jump;
+		}
+		if (Window::GetKeyboard()->KeyPressed(KeyCodes::F)) {
+			inputButtons |= PlayerInput::Dash;
+		}
+	}
+	if (thisServer) {
+		thisServer->UpdateServer();
+	}
+	if (thisClient) {
+		thisClient->UpdateClient();
+	}
 	timeToNextPacket -= dt;
 	if (timeToNextPacket < 0) {
 		if (thisServer) {
@@ -59,8 +85,13 @@ void NetworkedGame::UpdateGame(float dt) {
 		else if (thisClient) {
 			UpdateAsClient(dt);
 		}
-		timeToNextPacket += 1.0f / 20.0f; //20hz server/client update
+		timeToNextPacket += 1.0f / networkTickRate;
+	}
+	if (thisClient && !thisServer) {
+		clientGame->Update(dt);
+		SpawnPlayer();
 	}
+	UpdateNetworkStats(dt);
 
 	if (!thisServer && Window::GetKeyboard()->KeyPressed(KeyCodes::F9)) {
 		StartAsServer();
@@ -73,86 +104,108 @@ void NetworkedGame::UpdateGame(float dt) {
 }
 
 void NetworkedGame::UpdateAsServer(float dt) {
-	packetsToSnapshot--;
-	if (packetsToSnapshot < 0) {
-		BroadcastSnapshot(false);
-		packetsToSnapshot = 5;
-	}
-	else {
-		BroadcastSnapshot(true);
-	}
+	serverGame->Tick();
 }
 
 void NetworkedGame::UpdateAsClient(float dt) {
-	ClientPacket newPacket;
+	clientGame->Tick(SampleInput());
+}
 
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::SPACE)) {
-		//fire button pressed!
-		newPacket.buttonstates[0] = 1;
-		newPacket.lastID = 0; //You'll need to work this out somehow...
+PlayerInput NetworkedGame::SampleInput() {
+	PlayerInput input;
+	Vector3 move	= GetKeyboardMoveDirection();
+	input.moveX		= move.x;
+	input.moveZ		= move.z;
+	input.aimPitch	= world->GetMainCamera().GetPitch();
+	input.aimYaw	= world->GetMainCamera().GetYaw();
+	input.buttons	= inputButtons;
+	inputButtons	= 0;
+
+	if (Window::GetMouse()->ButtonDown(NCL::MouseButtons::Right)) {
+		input.buttons |= PlayerInput::Grapple;
 	}
-	thisClient->SendPacket(newPacket);
+	return input;
 }
 
-void NetworkedGame::BroadcastSnapshot(bool deltaFrame) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-
-	world->GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		NetworkObject* o = (*i)->GetNetworkObject();
-		if (!o) {
-			continue;
-		}
-		//TODO - you'll need some way of determining
-		//when a player has sent the server an acknowledgement
-		//and store the lastID somewhere. A map between player
-		//and an int could work, or it could be part of a 
-		//NetworkPlayer struct. 
-		int playerState = 0;
-		GamePacket* newPacket = nullptr;
-		if (o->WritePacket(&newPacket, deltaFrame, playerState)) {
-			thisServer->SendGlobalPacket(*newPacket);
-			delete newPacket;
+/*
+A server shows what it's sending to all of its clients, and a client
+shows its own connection. While the log is open, a row of running totals
+goes into it every second.
+*/
+void NetworkedGame::UpdateNetworkStats(float dt) {
+	NetworkBase* network = thisServer ? (NetworkBase*)thisServer : (NetworkBase*)thisClient;
+	if (!network) {
+		return;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F11)) {
+		ToggleStatsLog();
+	}
+	NetworkStats& stats = network->GetStats();
+	stats.Update(dt);
+	stats.Print(Vector2(5, 10));
+
+	if (statsLog.is_open()) {
+		statsLogTime	+= dt;
+		statsLogTimer	+= dt;
+		if (statsLogTimer >= 1.0f) {
+			stats.WriteCSVRow(statsLog, statsLogTime);
+			statsLogTimer = 0.0f;
 		}
 	}
 }
 
-void NetworkedGame::UpdateMinimumState() {
-	//Periodically remove old data from the server
-	int minID = INT_MAX;
-	int maxID = 0; //we could use this to see if a player is lagging behind?
-
-	for (auto i : stateIDs) {
-		minID = std::min(minID, i.second);
-		maxID = std::max(maxID, i.second);
-	}
-	//every client has acknowledged reaching at least state minID
-	//so we can get rid of any old states!
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	world->GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		NetworkObject* o = (*i)->GetNetworkObject();
-		if (!o) {
-			continue;
-		}
-		o->UpdateStateHistory(minID); //clear out old states so they arent taking up memory...
+void NetworkedGame::ToggleStatsLog() {
+	if (statsLog.is_open()) {
+		statsLog.close();
+		std::cout << "Stopped logging network stats" << std::endl;
+		return;
 	}
+	std::string filename = thisServer ? "NetworkStatsServer.csv" : "NetworkStatsClient.csv";
+	statsLog.open(filename);
+	if (!statsLog) {
+		std::cout << "Couldn't open " << filename << " for the network stats" << std::endl;
+		return;
+	}
+	NetworkBase* network = thisServer ? (NetworkBase*)thisServer : (NetworkBase*)thisClient;
+	network->GetStats().WriteCSVHeader(statsLog);
+	statsLogTime	= 0.0f;
+	statsLogTimer	= 0.0f;
+	std::cout << "Logging network stats to " << filename << std::endl;
 }
 
-void NetworkedGame::SpawnPlayer() {
-
+void NetworkedGame::MovePlayerObject(float dt) {
+	if (thisClient && !thisServer) {
+		return;
+	}
+	CourseworkGame::MovePlayerObject(dt);
 }
 
-void NetworkedGame::StartLevel() {
-
+/*
+The server spawns a player for every client that connects. Once ours has
+turned up, and we know it's ours from the first state the server sends
+for it, the camera follows it instead of the level's own player.
+*/
+void NetworkedGame::SpawnPlayer() {
+	PlayerObject* player = dynamic_cast<PlayerObject*>(clientGame->GetLocalPlayer());
+	if (!player) {
+		player = levelPlayer;
+	}
+	if (player && player != playerObject) {
+		playerObject = player;
+		playerGroundedCollider->AddToIgnoreList(player);
+	}
 }
 
-void NetworkedGame::ReceivePacket(int type, GamePacket* payload, int source) {
-	
+void NetworkedGame::StartLevel() {
+	quantisation = GetNetworkQuantisation();
+	if (serverGame) {
+		serverGame->SetQuantisation(quantisation);
+	}
+	if (clientGame) {
+		clientGame->SetQuantisation(quantisation);
+	}
+	InitNetworkObjects();
+	levelPlayer = playerObject;
 }
 
 void NetworkedGame::OnPlayerCollision(NetworkPlayer* a, NetworkPlayer* b) {
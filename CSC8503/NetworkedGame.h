@@ -1,6 +1,10 @@
 #pragma once
 #include "CourseworkGame.h"
 #include "NetworkBase.h"
+#include "NetworkObject.h"
+#include "ServerGame.h"
+#include "ClientGame.h"
+#include <fstream>
 
 namespace NCL {
 	namespace CSC8503 {
@@ -8,7 +12,7 @@ namespace NCL {
 		class GameClient;
 		class NetworkPlayer;
 
-		class NetworkedGame : public CourseworkGame, public PacketReceiver {
+		class NetworkedGame : public CourseworkGame {
 		public:
 			NetworkedGame();
 			~NetworkedGame();
@@ -22,27 +26,37 @@ namespace NCL {
 
 			void StartLevel();
 
-			void ReceivePacket(int type, GamePacket* payload, int source) override;
-
 			void OnPlayerCollision(NetworkPlayer* a, NetworkPlayer* b);
 
 		protected:
 			void UpdateAsServer(float dt);
 			void UpdateAsClient(float dt);
 
-			void BroadcastSnapshot(bool deltaFrame);
-			void UpdateMinimumState();
-			std::map<int, int> stateIDs;
+			//A client's player moves with the inputs ClientGame sends, not the ones read here
+			void MovePlayerObject(float dt) override;
+
+			void UpdateNetworkStats(float dt);
+			void ToggleStatsLog();
+
+			PlayerInput SampleInput();
+
+			ServerGame*			serverGame;
+			ClientGame*			clientGame;
+			StateQuantisation	quantisation;
+
+			PlayerObject*		levelPlayer;	//the level's own player, which the camera follows until the server spawns ours
+
+			std::ofstream	statsLog;		//F11 starts and stops writing the network stats to a CSV file
+			float			statsLogTime;
+			float			statsLogTimer;
+
+			float	networkTickRate;	//snapshots per second, each one a server tick
 
 			GameServer* thisServer;
 			GameClient* thisClient;
 			float timeToNextPacket;
-			int packetsToSnapshot;
-
-			std::vector<NetworkObject*> networkObjects;
 
-			std::map<int, GameObject*> serverPlayers;
-			GameObject* localPlayer;
+			uint8_t		inputButtons;	//client: buttons pressed since the last input was sent
 		};
 	}
 }
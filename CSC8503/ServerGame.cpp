@@ -0,0 +1,431 @@
+#include "ServerGame.h"
+#include "GameServer.h"
+#include "GameWorld.h"
+#include "GameLevel.h"
+#include "PhysicsObject.h"
+#include "SessionRecording.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+const float	playerMoveImpulse		= 20.0f;
+const float	playerJumpImpulse		= 32.0f;
+const float	playerDashImpulse		= 128.0f;
+const float	playerGrappleImpulse	= 1.0f;
+
+ServerGame::ServerGame(GameLevel& level, GameServer& server, float tickRate) : level(level), world(level.GetWorld()), server(server) {
+	this->tickRate	= tickRate;
+	serverStateID	= -1;
+	spawnVersion	= 0;
+	recorder		= nullptr;
+	scheduler.SetTickRate(tickRate);
+
+	snapshotPending		= false;
+	snapshotThreadQuit	= false;
+}
+
+ServerGame::~ServerGame() {
+	SetSnapshotThread(false);
+}
+
+/*
+When a server hosts more than one game, this is left to whatever routes
+each peer to its game, and the games just get passed their own packets.
+*/
+void ServerGame::RegisterPacketHandlers() {
+	server.RegisterPacketHandler(Received_State, this, ClientPacket::MinimumSize);
+	server.RegisterPacketHandler(Player_Connected, this);
+	server.RegisterPacketHandler(Player_Disconnected, this);
+}
+
+/*
+Everything the server sends has to go through its queue while this is
+on, as the ENet host can only be used by the main thread - UpdateServer
+sends whatever has been queued up since it was last called.
+*/
+void ServerGame::SetSnapshotThread(bool state) {
+	if (state == snapshotThread.joinable()) {
+		return;
+	}
+	if (state) {
+		server.SetDeferredSends(true);
+		snapshotThreadQuit	= false;
+		snapshotThread		= std::thread(&ServerGame::SnapshotThreadMain, this);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(snapshotLock);
+		snapshotThreadQuit = true;
+	}
+	snapshotSignal.notify_all();
+	snapshotThread.join();
+	server.SetDeferredSends(false);
+}
+
+void ServerGame::SnapshotThreadMain() {
+	std::unique_lock<std::mutex> lock(snapshotLock);
+	while (true) {
+		snapshotSignal.wait(lock, [&] { return snapshotPending || snapshotThreadQuit; });
+		if (!snapshotPending) {
+			return;
+		}
+		lock.unlock();
+		WriteSnapshots();
+		lock.lock();
+		snapshotPending = false;
+		snapshotSignal.notify_all();
+	}
+}
+
+void ServerGame::WaitForSnapshots() {
+	std::unique_lock<std::mutex> lock(snapshotLock);
+	snapshotSignal.wait(lock, [&] { return !snapshotPending; });
+}
+
+void ServerGame::SetQuantisation(const StateQuantisation& q) {
+	snapshotBuilder.SetQuantisation(q);
+	spawnBuilder.SetQuantisation(q);
+	interest.SetWorldSize(Vector2(
+		std::max(std::abs(q.boundsMin.x), std::abs(q.boundsMax.x)),
+		std::max(std::abs(q.boundsMin.z), std::abs(q.boundsMax.z))));
+}
+
+/*
+The only part of a tick's snapshots that touches the world is copying out
+its state - everything after that, per client, can happen on the snapshot
+thread while the main thread simulates the next tick. Until the last
+tick's snapshots are done, the scheduler and the network objects' state
+histories belong to the snapshot thread, so nothing else touches them.
+*/
+void ServerGame::Tick() {
+	WaitForSnapshots();
+	if (recorder) {
+		recorder->RecordTick(serverStateID + 1);
+	}
+	ApplySchedulerEvents();
+	CaptureSnapshotState();
+	SendSpawns();
+
+	if (snapshotThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(snapshotLock);
+			snapshotPending = true;
+		}
+		snapshotSignal.notify_all();
+	}
+	else {
+		WriteSnapshots();
+	}
+	lagCompensator.Record(serverStateID, world);
+	SendPlayerStates();
+	ApplyPlayerInputs();
+}
+
+/*
+The server runs this on the real player, and the client runs it on its
+predicted copy, so they have to stay identical. Nothing in here can look
+at anything the client doesn't have, like the grounded trigger - a body
+that isn't moving up or down is treated as standing on something.
+*/
+void ServerGame::ApplyPlayerInput(GameObject* player, const PlayerInput& input, float dt) {
+	PhysicsObject* physicsObject = player->GetPhysicsObject();
+	if (!physicsObject) {
+		return;
+	}
+	physicsObject->ApplyLinearImpulse(Vector3(input.moveX, 0.0f, input.moveZ) * playerMoveImpulse * dt);
+
+	if (input.buttons & PlayerInput::Dash) {
+		Quaternion aim = Quaternion::EulerAnglesToQuaternion(input.aimPitch, input.aimYaw, 0.0f);
+		physicsObject->ApplyLinearImpulse(aim * Vector3(0, 0, -1) * playerDashImpulse * dt);
+	}
+	if ((input.buttons & PlayerInput::Jump) && std::abs(physicsObject->GetLinearVelocity().y) < 0.1f) {
+		physicsObject->ApplyLinearImpulse(Vector3(0, playerJumpImpulse, 0) * dt);
+	}
+	PlayerObject* grappler = dynamic_cast<PlayerObject*>(player);
+	if (grappler && grappler->IsGrappling()) {
+		Vector3 direction = (grappler->GetGrapplePoint() - player->GetTransform().GetPosition()).Normalised();
+		physicsObject->ApplyLinearImpulse(direction * playerGrappleImpulse * dt);
+	}
+}
+
+/*
+The grapple fires when the button first goes down. On the server, the ray
+is tested against the world as the client saw it when it pressed the
+button, so a client with a lot of latency still hits what it aimed at.
+*/
+void ServerGame::UpdatePlayerGrapple(GameObject* player, const PlayerInput& input, const GrappleRaycast& raycast) {
+	PlayerObject* grappler = dynamic_cast<PlayerObject*>(player);
+	if (!grappler) {
+		return;
+	}
+	if (!(input.buttons & PlayerInput::Grapple)) {
+		grappler->SetGrappling(false);
+		return;
+	}
+	if (grappler->IsGrappling()) {
+		return;
+	}
+	Quaternion aim = Quaternion::EulerAnglesToQuaternion(input.aimPitch, input.aimYaw, 0.0f);
+	Ray ray(player->GetTransform().GetPosition(), aim * Vector3(0, 0, -1));
+
+	RayCollision closestCollision;
+	bool hit = raycast(ray, closestCollision);
+
+	grappler->SetGrappling(hit);
+	grappler->SetGrapplePoint(hit ? closestCollision.collidedAt : Vector3(0, 0, 0));
+}
+
+/*
+The object isn't in the world until the world next updates, and nothing
+is sent about it until the tick after that - so it can be spawned without
+waiting for the snapshot thread, which never looks at anything new.
+*/
+GameObject* ServerGame::SpawnObject(int prefab, const Vector3& position) {
+	if (prefab < 0 || prefab >= PrefabCount) {
+		return nullptr;
+	}
+	int networkID		= level.GetNetworkIDs().Allocate(serverStateID + 1);
+	NetworkObject* n	= level.SpawnNetworkObject(prefab, networkID, position);
+	GameObject* object	= &n->GetGameObject();
+
+	spawnedObjects[networkID] = { object, prefab, serverStateID + 1 };
+	spawnVersion++;
+	return object;
+}
+
+void ServerGame::DespawnObject(GameObject* object) {
+	NetworkObject* n = object ? object->GetNetworkObject() : nullptr;
+	if (!n || !spawnedObjects.count(n->GetNetworkID())) {
+		return;
+	}
+	//The snapshot thread may still be writing the last tick's state for it
+	WaitForSnapshots();
+
+	int networkID = n->GetNetworkID();
+	spawnedObjects.erase(networkID);
+	spawnVersion++;
+
+	lagCompensator.RemoveObject(object);
+	for (auto& [peer, player] : serverPlayers) {
+		if (player == object) {
+			player = nullptr;
+		}
+	}
+	level.DespawnNetworkObject(networkID);
+	level.GetNetworkIDs().Free(networkID, serverStateID);
+}
+
+void ServerGame::SendPlayerStates() {
+	for (const auto& [peer, player] : serverPlayers) {
+		if (!player || !player->GetNetworkObject()) {
+			continue;
+		}
+		PlayerStatePacket packet;
+		packet.networkID		= player->GetNetworkObject()->GetNetworkID();
+		packet.lastInput		= serverPlayerInputs.count(peer) ? serverPlayerInputs[peer] : -1;
+		packet.position			= player->GetTransform().GetPosition();
+		packet.orientation		= player->GetTransform().GetOrientation();
+		packet.linearVelocity	= player->GetPhysicsObject()->GetLinearVelocity();
+		packet.angularVelocity	= player->GetPhysicsObject()->GetAngularVelocity();
+		server.SendPacketToPeer(peer, packet);
+	}
+}
+
+/*
+Each player gets at most one input a tick, however many have arrived since
+the last one, so the server moves it exactly as often as the client's
+prediction did. They're applied after the player states have been sent,
+so that the next state sent is the one after the physics has run with them.
+*/
+void ServerGame::ApplyPlayerInputs() {
+	float dt = 1.0f / tickRate;
+	for (auto& [peer, buffer] : bufferedPlayerInputs) {
+		auto player = serverPlayers.find(peer);
+		if (buffer.empty() || player == serverPlayers.end() || !player->second) {
+			continue;
+		}
+		GameObject*	o		= player->second;
+		PlayerInput	input	= buffer.front();
+		buffer.erase(buffer.begin());
+
+		UpdatePlayerGrapple(o, input, [&](const Ray& r, RayCollision& collision) {
+			return lagCompensator.Raycast(r, input.viewTick, world, collision, o, { LAYER_PLAYER });
+		});
+		ApplyPlayerInput(o, input, dt);
+		serverPlayerInputs[peer] = input.sequence;
+	}
+}
+
+void ServerGame::ApplySchedulerEvents() {
+	for (const SchedulerEvent& e : schedulerEvents) {
+		switch (e.type) {
+			case Player_Connected:		scheduler.AddPeer(e.peer);									break;
+			case Player_Disconnected:	scheduler.RemovePeer(e.peer);								break;
+			case Received_State:		scheduler.OnAcknowledged(e.peer, e.sequence, e.ackBits);	break;
+		}
+	}
+	schedulerEvents.clear();
+}
+
+/*
+Every tick gets a new state ID, and each object's state is copied under
+it, along with where each client's player is.
+*/
+void ServerGame::CaptureSnapshotState() {
+	const StateQuantisation& q = snapshotBuilder.GetQuantisation();
+
+	serverStateID++;
+	world.OperateOnNetworkContents([&](GameObject* o) {
+		o->GetNetworkObject()->UpdateLastChange(serverStateID, q);
+	});
+	interest.Update(world);
+
+	snapshotTargets.clear();
+	for (int peer : connectedPeers) {
+		SnapshotTarget target = { peer, false, Vector3() };
+		auto player = serverPlayers.find(peer);
+		if (player != serverPlayers.end() && player->second) {
+			target.hasViewpoint	= true;
+			target.viewpoint	= player->second->GetTransform().GetPosition();
+		}
+		snapshotTargets.push_back(target);
+	}
+}
+
+/*
+Each client is sent everything that's been spawned or despawned since it
+was last brought up to date, in as few packets as it'll fit in - for a
+client that's just connected, that's every spawned object there is. The
+scheduler takes each spawned object's state as one the client has, so its
+snapshots can be deltas from the start, or nothing at all if it's still.
+*/
+void ServerGame::SendSpawns() {
+	for (int peer : connectedPeers) {
+		ClientSpawns& client = clientSpawns[peer];
+		if (client.version == spawnVersion) {
+			continue;
+		}
+		client.version = spawnVersion;
+		spawnBuilder.Begin(server, peer, serverStateID);
+
+		//Gone, or gone and something else given its network ID since
+		for (auto i = client.objects.begin(); i != client.objects.end();) {
+			auto spawned = spawnedObjects.find(i->first);
+			if (spawned != spawnedObjects.end() && spawned->second.spawnTick == i->second) {
+				++i;
+				continue;
+			}
+			SpawnEntry entry;
+			entry.networkID	= i->first;
+			entry.spawned	= false;
+			spawnBuilder.AddEntry(entry);
+			scheduler.ForgetObject(peer, i->first);
+			i = client.objects.erase(i);
+		}
+		for (const auto& [networkID, spawned] : spawnedObjects) {
+			if (client.objects.count(networkID)) {
+				continue;
+			}
+			NetworkObject* n = spawned.object->GetNetworkObject();
+			if (n->GetTickState().stateID != serverStateID) {
+				client.version = -1; //wasn't in the world yet when this tick's state was copied
+				continue;
+			}
+			SpawnEntry entry;
+			entry.networkID	= networkID;
+			entry.prefab	= spawned.prefab;
+			entry.state		= n->WriteBaseline(serverStateID);
+			spawnBuilder.AddEntry(entry);
+			scheduler.SetBaseline(peer, networkID, serverStateID);
+			client.objects[networkID] = spawned.spawnTick;
+		}
+		spawnBuilder.End();
+	}
+}
+
+/*
+Each client gets its own snapshot, filled by the scheduler with whatever
+is most important to it until its bandwidth budget is used up.
+*/
+void ServerGame::WriteSnapshots() {
+	for (const SnapshotTarget& target : snapshotTargets) {
+		scheduler.WriteSnapshot(target.peer, serverStateID, target.hasViewpoint ? &target.viewpoint : nullptr, interest, snapshotBuilder, server);
+	}
+	UpdateMinimumState();
+}
+
+void ServerGame::UpdateMinimumState() {
+	//Periodically remove old data from the server
+	//States that are too old to still be waiting on an acknowledgement can go,
+	//unless some client is still having deltas built against them
+	int ackWindowID = serverStateID - SnapshotScheduler::SentPacketCount;
+
+	//The interest manager's copy of the list, as the world's may be changing on the main thread
+	for (GameObject* object : interest.GetAllObjects()) {
+		NetworkObject* o = object->GetNetworkObject();
+		int minID = std::min(ackWindowID, scheduler.GetMinimumConfirmedState(o->GetNetworkID()));
+		o->UpdateStateHistory(minID); //clear out old states so they arent taking up memory...
+	}
+}
+
+void ServerGame::ReceivePacket(int type, GamePacket* payload, int source) {
+	if (recorder) {
+		recorder->RecordIncoming(serverStateID + 1, source, *payload);
+	}
+	switch (type) {
+		case Player_Connected: {
+			connectedPeers.insert(source);
+			schedulerEvents.push_back({ type, source, -1, 0 });
+			serverPlayerInputs[source] = -1;
+			serverPlayers[source] = SpawnObject(Prefab_Player, level.GetPlayerSpawnPoint(source));
+		}break;
+		case Player_Disconnected: {
+			connectedPeers.erase(source);
+			schedulerEvents.push_back({ type, source, -1, 0 });
+			serverPlayerInputs.erase(source);
+			bufferedPlayerInputs.erase(source);
+			clientSpawns.erase(source);
+
+			auto player = serverPlayers.find(source);
+			if (player != serverPlayers.end()) {
+				DespawnObject(player->second);
+				serverPlayers.erase(player);
+			}
+		}break;
+		case Received_State: {
+			ClientPacket* p = (ClientPacket*)payload;
+			schedulerEvents.push_back({ type, source, p->lastID, p->ackBits });
+
+			auto player = serverPlayers.find(source);
+			if (player == serverPlayers.end() || !player->second) {
+				break;
+			}
+			//Any inputs that went missing in earlier packets are filled in too. The
+			//sequence numbers are the client's, so any too far ahead are dropped
+			PlayerInput inputs[ClientPacket::MaxInputs];
+			int count = p->ReadInputs(inputs, ClientPacket::MaxInputs);
+			if (count == 0 || inputs[count - 1].sequence < 0) {
+				break;
+			}
+			int& lastApplied = serverPlayerInputs[source];
+			std::vector<PlayerInput>& buffer = bufferedPlayerInputs[source];
+			if (buffer.empty() && (lastApplied < 0 || inputs[0].sequence - lastApplied > MaxInputsAhead)) {
+				lastApplied = inputs[0].sequence - 1; //the first we've heard from it, or the first in a long time
+			}
+			for (int i = count - 1; i >= 0; --i) {
+				const PlayerInput& input = inputs[i];
+				if (input.sequence <= lastApplied || input.sequence - lastApplied > MaxInputsAhead) {
+					continue;
+				}
+				auto at = std::lower_bound(buffer.begin(), buffer.end(), input.sequence,
+					[](const PlayerInput& a, int sequence) { return a.sequence < sequence; });
+				if (at == buffer.end() || at->sequence != input.sequence) {
+					buffer.insert(at, input);
+				}
+			}
+			if ((int)buffer.size() > MaxBufferedInputs) {
+				buffer.erase(buffer.begin(), buffer.end() - MaxBufferedInputs);
+			}
+		}break;
+	}
+}
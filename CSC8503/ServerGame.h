@@ -0,0 +1,159 @@
+#pragma once
+#include "NetworkBase.h"
+#include "NetworkObject.h"
+#include "SnapshotBuilder.h"
+#include "SpawnBuilder.h"
+#include "InterestManager.h"
+#include "SnapshotScheduler.h"
+#include "LagCompensator.h"
+#include <mutex>
+#include <condition_variable>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameServer;
+		class GameWorld;
+		class GameLevel;
+		class SessionRecorder;
+
+		/*
+		The authoritative side of a networked game - spawns a player for each
+		client that connects, applies client inputs, and sends each client
+		what's been spawned and despawned, its snapshots and its player state
+		once a tick.
+		It never touches a window or renderer, so it runs the same inside the
+		windowed game (hosting with F9) as it does in the headless server.
+		*/
+		class ServerGame : public PacketReceiver {
+		public:
+			ServerGame(GameLevel& level, GameServer& server, float tickRate = 20.0f);
+			~ServerGame();
+
+			//Only for a server running this game alone
+			void RegisterPacketHandlers();
+			//Also only for a server running this game alone - snapshots are written and
+			//sent on a thread of their own, while the main thread gets on with the next tick
+			void SetSnapshotThread(bool state);
+
+			void SetQuantisation(const StateQuantisation& q);
+			void SetSnapshotCompression(bool state) {
+				snapshotBuilder.SetCompression(state);
+			}
+			//Records every tick, every packet received, and every snapshot sent - null to stop
+			void SetRecorder(SessionRecorder* r) {
+				WaitForSnapshots();
+				recorder = r;
+				snapshotBuilder.SetRecorder(r);
+				spawnBuilder.SetRecorder(r);
+			}
+
+			//Creates a networked object from one of the level's prefabs, and sends it to every client next tick
+			GameObject* SpawnObject(int prefab, const Vector3& position);
+			//Only for spawned objects - deletes it, and tells every client it's gone next tick
+			void		DespawnObject(GameObject* object);
+
+			//Called once per network tick, after the world has been simulated up to it
+			void Tick();
+			//Returns once the last tick's snapshots have all been written
+			void WaitForSnapshots();
+
+			void ReceivePacket(int type, GamePacket* payload, int source) override;
+
+			int GetStateID() const {
+				return serverStateID;
+			}
+			float GetTickRate() const {
+				return tickRate;
+			}
+			const SnapshotBuilder& GetSnapshotBuilder() const {
+				return snapshotBuilder;
+			}
+			int GetClientCount() const {
+				return (int)connectedPeers.size();
+			}
+			int GetSpawnedCount() const {
+				return (int)spawnedObjects.size();
+			}
+
+			//Shared with the client's prediction, so both ends move players identically
+			static void ApplyPlayerInput(GameObject* player, const PlayerInput& input, float dt);
+
+			typedef std::function<bool(const Ray&, RayCollision&)> GrappleRaycast;
+			static void UpdatePlayerGrapple(GameObject* player, const PlayerInput& input, const GrappleRaycast& raycast);
+
+		protected:
+			void ApplySchedulerEvents();
+			void ApplyPlayerInputs();
+			void CaptureSnapshotState();
+			void SendSpawns();
+			void WriteSnapshots();
+			void UpdateMinimumState();
+			void SendPlayerStates();
+
+			void SnapshotThreadMain();
+
+			GameLevel&	level;
+			GameWorld&	world;
+			GameServer&	server;
+			float		tickRate;
+
+			SnapshotBuilder		snapshotBuilder;
+			SpawnBuilder		spawnBuilder;
+			InterestManager		interest;
+			SnapshotScheduler	scheduler;
+			LagCompensator		lagCompensator;
+			SessionRecorder*	recorder;
+
+			std::set<int>	connectedPeers;
+			int				serverStateID;	//counts up every tick, new full states are stored under it
+
+			std::map<int, GameObject*>	serverPlayers;
+			std::map<int, int>			serverPlayerInputs;	//newest input sequence applied for each peer
+
+			//Inputs received from each peer but not applied yet, oldest first. Only one is applied
+			//a tick, so more than a few waiting would just be latency, and the oldest are skipped
+			static const int MaxBufferedInputs	= ClientPacket::MaxInputs / 2;
+			static const int MaxInputsAhead		= ClientPacket::MaxInputs * 2;	//of the last one applied
+			std::map<int, std::vector<PlayerInput>> bufferedPlayerInputs;
+
+			struct SpawnedObject {
+				GameObject*	object;
+				int			prefab;
+				int			spawnTick;	//tells it apart from whatever has its network ID before or after
+			};
+			std::map<int, SpawnedObject> spawnedObjects;	//by network ID
+			int spawnVersion;	//counts up whenever an object is spawned or despawned
+
+			//The spawned objects each client has been sent, and which spawn tick each one was
+			struct ClientSpawns {
+				int					version = -1;	//spawnVersion when it was last brought up to date
+				std::map<int, int>	objects;
+			};
+			std::map<int, ClientSpawns> clientSpawns;
+
+			//Connections and acknowledgements wait here until the scheduler is free - the type is
+			//the message they came in, and only acknowledgements use sequence and ackBits
+			struct SchedulerEvent {
+				int			type;
+				int			peer;
+				int			sequence;
+				uint32_t	ackBits;
+			};
+			std::vector<SchedulerEvent> schedulerEvents;
+
+			//Who gets a snapshot this tick, and from where, copied at the start of the tick
+			struct SnapshotTarget {
+				int		peer;
+				bool	hasViewpoint;
+				Vector3	viewpoint;
+			};
+			std::vector<SnapshotTarget> snapshotTargets;
+
+			std::thread				snapshotThread;
+			std::mutex				snapshotLock;
+			std::condition_variable	snapshotSignal;
+			bool					snapshotPending;	//a tick's snapshots are waiting to be, or being, written
+			bool					snapshotThreadQuit;
+		};
+	}
+}
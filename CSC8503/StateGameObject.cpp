@@ -12,6 +12,7 @@ StateGameObject::StateGameObject()
 {
 	counter = 0.0f;
 	stateMachine = new StateMachine();
+	isAIAgent = true;
 
 }
 StateGameObject::~StateGameObject() {
@@ -62,7 +63,8 @@ EnemyObject::EnemyObject(LevelData* l, GameWorld* g, const std::string& n)
 				
 				if (isSearchingForSpot)
 				{
-					Vector3 target(levelData->GetWalkableSpots()[RandomValue(0,levelData->GetWalkableSpots().size()-1)].position);
+					std::uniform_int_distribution<size_t> spot(0, levelData->GetWalkableSpots().size() - 1);
+					Vector3 target(levelData->GetWalkableSpots()[spot(gameWorld->GetRandomEngine())].position);
 					target.y = 0;
 					timeTraveling = 0.0f;
 					this->SetTargetDestination(target);
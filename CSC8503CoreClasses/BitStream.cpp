@@ -0,0 +1,122 @@
+#include "BitStream.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+static uint32_t BitMask(int bitCount) {
+	return bitCount >= 32 ? 0xFFFFFFFF : ((1u << bitCount) - 1);
+}
+
+BitWriter::BitWriter(char* buffer, int byteCapacity) {
+	Reset(buffer, byteCapacity);
+}
+
+void BitWriter::Reset(char* buffer, int byteCapacity) {
+	data			= buffer;
+	capacity		= byteCapacity;
+	bytesWritten	= 0;
+	scratch			= 0;
+	scratchBits		= 0;
+	overflowed		= false;
+}
+
+void BitWriter::WriteBits(uint32_t value, int bitCount) {
+	scratch		|= (uint64_t)(value & BitMask(bitCount)) << scratchBits;
+	scratchBits += bitCount;
+
+	while (scratchBits >= 8) {
+		if (bytesWritten < capacity) {
+			data[bytesWritten] = (char)(scratch & 0xFF);
+		}
+		else {
+			overflowed = true;
+		}
+		bytesWritten++;
+		scratch		>>= 8;
+		scratchBits	 -= 8;
+	}
+}
+
+void BitWriter::WriteVarUInt(uint32_t value) {
+	while (value >= 0x80) {
+		WriteBits((value & 0x7F) | 0x80, 8);
+		value >>= 7;
+	}
+	WriteBits(value, 8);
+}
+
+void BitWriter::WriteVarInt(int32_t value) {
+	WriteVarUInt(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void BitWriter::WriteStream(const BitWriter& other) {
+	for (int i = 0; i < other.bytesWritten && i < other.capacity; ++i) {
+		WriteBits((uint8_t)other.data[i], 8);
+	}
+	if (other.scratchBits > 0) {
+		WriteBits((uint32_t)other.scratch, other.scratchBits);
+	}
+	overflowed |= other.overflowed;
+}
+
+void BitWriter::Flush() {
+	if (scratchBits > 0) {
+		WriteBits(0, 8 - scratchBits);
+	}
+}
+
+BitReader::BitReader(const char* buffer, int byteCount) {
+	data		= buffer;
+	size		= byteCount;
+	bytesRead	= 0;
+	scratch		= 0;
+	scratchBits = 0;
+	overflowed	= false;
+}
+
+uint32_t BitReader::ReadBits(int bitCount) {
+	while (scratchBits < bitCount) {
+		uint8_t byte = 0;
+		if (bytesRead < size) {
+			byte = (uint8_t)data[bytesRead];
+			bytesRead++;
+		}
+		else {
+			overflowed = true;
+		}
+		scratch		|= (uint64_t)byte << scratchBits;
+		scratchBits += 8;
+	}
+	uint32_t value = (uint32_t)scratch & BitMask(bitCount);
+	scratch		>>= bitCount;
+	scratchBits	 -= bitCount;
+	return value;
+}
+
+uint32_t BitReader::ReadVarUInt() {
+	uint32_t value	= 0;
+	int shift		= 0;
+	while (shift < 32) {
+		uint32_t byte = ReadBits(8);
+		value |= (byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			break;
+		}
+		shift += 7;
+	}
+	return value;
+}
+
+int BitReader::ReadVarNonNegative() {
+	uint32_t value = ReadVarUInt();
+	if (value > INT_MAX) {
+		overflowed = true;
+		return 0;
+	}
+	return (int)value;
+}
+
+int32_t BitReader::ReadVarInt() {
+	uint32_t value = ReadVarUInt();
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Writes values using only as many bits as they need, least significant
+		bit first, into a buffer owned by someone else. Writing past the end
+		of the buffer doesn't crash, it just sets the overflow flag, so a
+		whole packet can be written and checked once at the end.
+		*/
+		class BitWriter {
+		public:
+			BitWriter(char* buffer = nullptr, int byteCapacity = 0);
+
+			void Reset(char* buffer, int byteCapacity);
+
+			void WriteBits(uint32_t value, int bitCount);
+			void WriteBool(bool value) {
+				WriteBits(value ? 1 : 0, 1);
+			}
+			//7 bits at a time, so small numbers (like most object IDs) take a single byte
+			void WriteVarUInt(uint32_t value);
+			//Zigzag encoded first, so small negative numbers are small too
+			void WriteVarInt(int32_t value);
+			//Appends everything written to another stream
+			void WriteStream(const BitWriter& other);
+
+			//Writes out any partially filled byte
+			void Flush();
+
+			int GetBitsWritten() const {
+				return bytesWritten * 8 + scratchBits;
+			}
+			int GetBytesWritten() const {
+				return bytesWritten + (scratchBits > 0 ? 1 : 0);
+			}
+			bool HasOverflowed() const {
+				return overflowed;
+			}
+
+		protected:
+			char*		data;
+			int			capacity;
+			int			bytesWritten;
+			uint64_t	scratch;
+			int			scratchBits;
+			bool		overflowed;
+		};
+
+		class BitReader {
+		public:
+			BitReader(const char* buffer, int byteCount);
+
+			uint32_t ReadBits(int bitCount);
+			bool ReadBool() {
+				return ReadBits(1) != 0;
+			}
+			uint32_t ReadVarUInt();
+			int32_t ReadVarInt();
+			//For IDs, counts and the like - one too big for an int is treated
+			//the same as reading past the end, so it can never come out negative
+			int ReadVarNonNegative();
+
+			//Reading past the end gives zeroes and sets this
+			bool HasOverflowed() const {
+				return overflowed;
+			}
+			int GetBitsRemaining() const {
+				return (size - bytesRead) * 8 + scratchBits;
+			}
+
+		protected:
+			const char* data;
+			int			size;
+			int			bytesRead;
+			uint64_t	scratch;
+			int			scratchBits;
+			bool		overflowed;
+		};
+	}
+}
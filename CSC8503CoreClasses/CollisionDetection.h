@@ -29,12 +29,23 @@ namespace NCL {
 			GameObject* b;		
 			int		framesLeft;
 
+			//Copied from the objects when the pair is made, so ordering contacts never reads an object
+			int		worldIDA = -1;
+			int		worldIDB = -1;
+
 			ContactPoint point;
 
 			CollisionInfo() {
 
 			}
 
+			void SetObjects(GameObject* objectA, GameObject* objectB) {
+				a			= objectA;
+				b			= objectB;
+				worldIDA	= a->GetWorldID();
+				worldIDB	= b->GetWorldID();
+			}
+
 			void AddContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p) {
 				point.localA		= localA;
 				point.localB		= localB;
@@ -43,9 +54,10 @@ namespace NCL {
 			}
 
 			//Advanced collision detection / resolution
+			//Ordered by world ID, so iteration order doesn't depend on where the objects were allocated
 			bool operator < (const CollisionInfo& other) const {
-				size_t otherHash = (size_t)other.a + ((size_t)other.b << 32);
-				size_t thisHash  = (size_t)a + ((size_t)b << 32);
+				uint64_t otherHash	= (uint64_t)(uint32_t)other.worldIDA | ((uint64_t)(uint32_t)other.worldIDB << 32);
+				uint64_t thisHash	= (uint64_t)(uint32_t)worldIDA | ((uint64_t)(uint32_t)worldIDB << 32);
 
 				if (thisHash < otherHash) {
 					return true;
@@ -3,6 +3,7 @@ using namespace NCL;
 
 std::vector<Debug::DebugStringEntry>	Debug::stringEntries;
 std::vector<Debug::DebugLineEntry>		Debug::lineEntries;
+std::mutex								Debug::entryLock;
 
 SimpleFont* Debug::debugFont = nullptr;
 
@@ -24,6 +25,7 @@ void Debug::Print(const std::string& text, const Vector2& pos, const Vector4& co
 	newEntry.position = pos;
 	newEntry.colour = colour;
 
+	std::lock_guard<std::mutex> lock(entryLock);
 	stringEntries.emplace_back(newEntry);
 }
 
@@ -36,6 +38,7 @@ void Debug::DrawLine(const Vector3& startpoint, const Vector3& endpoint, const V
 	newEntry.colourB = colour;
 	newEntry.time = time;
 
+	std::lock_guard<std::mutex> lock(entryLock);
 	lineEntries.emplace_back(newEntry);
 }
 void Debug::DrawAABBLines(const Vector3& centre, const Vector3& halfSizes, const Vector4& colour, float time)
@@ -145,6 +148,7 @@ void Debug::DrawAxisLines(const Matrix4& modelMatrix, float scaleBoost, float ti
 }
 
 void Debug::UpdateRenderables(float dt) {
+	std::lock_guard<std::mutex> lock(entryLock);
 	int trim = 0;
 	for (int i = 0; i < lineEntries.size(); ) {
 		DebugLineEntry* e = &lineEntries[i];
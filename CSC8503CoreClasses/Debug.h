@@ -4,6 +4,7 @@
 #include "Matrix4.h"
 #include "SimpleFont.h"
 #include "Quaternion.h"
+#include <mutex>
 namespace NCL {
 	using namespace NCL::Maths;
 	using namespace NCL::Rendering;
@@ -59,6 +60,7 @@ namespace NCL {
 
 		static std::vector<DebugStringEntry>	stringEntries;
 		static std::vector<DebugLineEntry>		lineEntries;
+		static std::mutex						entryLock; //a server can be updating several worlds at once
 
 		static SimpleFont* debugFont;
 		static Texture* fontTexture;
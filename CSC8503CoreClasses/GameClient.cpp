@@ -1,14 +1,23 @@
 #include "GameClient.h"
+#include "LoopbackNetwork.h"
+#include "NetworkStats.h"
 #include "./enet/enet.h"
 using namespace NCL;
 using namespace CSC8503;
 
 GameClient::GameClient()	{
-	netHandle = enet_host_create(nullptr, 1, 1, 0, 0);
+	netHandle	= nullptr;
+	netPeer		= nullptr;
 }
 
 GameClient::~GameClient()	{
-	enet_host_destroy(netHandle);
+	if (loopback) {
+		loopback->Disconnect(loopbackEndpoint);
+	}
+	if (netHandle) {
+		enet_host_destroy(netHandle);
+	}
+	netHandle = nullptr;
 }
 
 bool GameClient::Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum) 
@@ -17,33 +26,67 @@ bool GameClient::Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum
 	address.port = portNum;
 	address.host = (d << 24) | (c << 16) | (b << 8) | (a);
 
-	netPeer = enet_host_connect(netHandle, &address, 2, 0);
+	if (!netHandle) {
+		netHandle = enet_host_create(nullptr, 1, ChannelCount, 0, 0);
+	}
+	netPeer = netHandle ? enet_host_connect(netHandle, &address, ChannelCount, 0) : nullptr;
 
 	return netPeer != nullptr;
 }
 
+bool GameClient::Connect(LoopbackNetwork& network) {
+	loopback			= &network;
+	loopbackEndpoint	= network.Connect();
+	return true;
+}
+
 void GameClient::UpdateClient() 
 {
+	if (loopback) {
+		LoopbackNetwork::Event event;
+		while (loopback->Receive(loopbackEndpoint, event)) {
+			OnEvent(event.type, event.packet);
+		}
+		const LoopbackNetwork::LinkStats& download = loopback->GetServerDownloadStats();
+		stats->SetRoundTripTime(loopback->GetRoundTripTime() * 1000.0f);
+		stats->SetPacketLoss(download.packetsSent > 0 ? (float)download.packetsLost / download.packetsSent : 0.0f);
+		return;
+	}
 	if (netHandle == nullptr) return;
 	ENetEvent event;
 	while (enet_host_service(netHandle, &event, 0) > 0)
 	{
-		if (event.type == ENET_EVENT_TYPE_CONNECT)
-		{
-			std::cout << "Connect to server!" << std::endl;
-		}
-		else if (event.type == ENET_EVENT_TYPE_RECEIVE)
-		{
-			std::cout << "Client: Packet recieved..." << std::endl;
-			GamePacket* packet = (GamePacket*)event.packet->data;
-			ProcessPacket(packet);
-		}
-		enet_packet_destroy(event.packet);
+		OnEvent(event.type, event.packet);
+	}
+	if (netPeer) {
+		stats->SetRoundTripTime((float)netPeer->roundTripTime);
+		stats->SetPacketLoss((float)netPeer->packetLoss / (float)ENET_PEER_PACKET_LOSS_SCALE);
+	}
+}
+
+void GameClient::OnEvent(int type, _ENetPacket* received)
+{
+	if (type == ENET_EVENT_TYPE_CONNECT)
+	{
+		std::cout << "Connect to server!" << std::endl;
+	}
+	else if (type == ENET_EVENT_TYPE_RECEIVE)
+	{
+		ProcessPacket(received);
 	}
 }
 
 void GameClient::SendPacket(GamePacket&  payload)
 {
-	ENetPacket* dataPacket = enet_packet_create(&payload, payload.GetTotalSize(), 0);
-	enet_peer_send(netPeer, 0, dataPacket);
+	if (!loopback && !netPeer) {
+		return;
+	}
+	ENetPacket* dataPacket	= CreatePacket(payload);
+	int			channel		= GetChannel(payload.type);
+	stats->RecordPacket(NetworkStats::Sent, payload.type, (int)dataPacket->dataLength);
+	if (loopback) {
+		loopback->Send(loopbackEndpoint, LoopbackNetwork::ServerEndpoint, dataPacket, channel);
+		return;
+	}
+	enet_peer_send(netPeer, channel, dataPacket);
 }
@@ -13,11 +13,14 @@ namespace NCL {
 			~GameClient();
 
 			bool Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum);
+			bool Connect(LoopbackNetwork& network);
 
 			void SendPacket(GamePacket&  payload);
 
 			void UpdateClient();
 		protected:	
+			void OnEvent(int type, _ENetPacket* received);
+
 			_ENetPeer*	netPeer;
 		};
 	}
@@ -3,6 +3,7 @@
 #include "PhysicsObject.h"
 #include "RenderObject.h"
 #include "NetworkObject.h"
+#include "GameWorld.h"
 #include "Debug.h"
 using namespace NCL::CSC8503;
 
@@ -15,8 +16,28 @@ GameObject::GameObject(const std::string& objectName)	{
 	renderObject	= nullptr;
 	networkObject	= nullptr;
 	isColliding = false;
-	
+	isAIAgent		= false;
+	world			= nullptr;
+	for (int& i : componentIndices) {
+		i = -1;
+	}
+}
 
+bool GameObject::HasComponent(ComponentType type) const {
+	switch (type) {
+		case ComponentType::Physics:	return physicsObject != nullptr;
+		case ComponentType::Render:		return isActive && renderObject != nullptr;
+		case ComponentType::Network:	return networkObject != nullptr;
+		case ComponentType::AI:			return isAIAgent;
+		case ComponentType::MaxTypes:	break;
+	}
+	return false;
+}
+
+void GameObject::OnComponentsChanged() {
+	if (world) {
+		world->UpdateComponentLists(this);
+	}
 }
 
 
@@ -9,6 +9,17 @@ namespace NCL::CSC8503 {
 	class NetworkObject;
 	class RenderObject;
 	class PhysicsObject;
+	class GameWorld;
+
+	//The GameWorld keeps a dense list of objects for each of these,
+	//so that each system only has to iterate over what it cares about
+	enum class ComponentType {
+		Physics,
+		Render,
+		Network,
+		AI,
+		MaxTypes
+	};
 
 	class GameObject	{
 	public:
@@ -27,6 +38,11 @@ namespace NCL::CSC8503 {
 			return isActive;
 		}
 
+		void SetActive(bool state) {
+			isActive = state;
+			OnComponentsChanged();
+		}
+
 		
 		Transform& GetTransform() {
 			return transform;
@@ -46,10 +62,32 @@ namespace NCL::CSC8503 {
 
 		void SetRenderObject(RenderObject* newObject) {
 			renderObject = newObject;
+			OnComponentsChanged();
 		}
 
 		void SetPhysicsObject(PhysicsObject* newObject) {
 			physicsObject = newObject;
+			OnComponentsChanged();
+		}
+
+		void SetNetworkObject(NetworkObject* newObject) {
+			networkObject = newObject;
+			OnComponentsChanged();
+		}
+
+		bool IsAIAgent() const {
+			return isAIAgent;
+		}
+
+		void SetAIAgent(bool state) {
+			isAIAgent = state;
+			OnComponentsChanged();
+		}
+
+		bool HasComponent(ComponentType type) const;
+
+		GameWorld* GetWorld() const {
+			return world;
 		}
 
 		const std::string& GetName() const {
@@ -103,6 +141,10 @@ namespace NCL::CSC8503 {
 		}
 
 	protected:
+		friend class GameWorld;
+
+		void OnComponentsChanged();
+
 		Transform			transform;
 
 		CollisionVolume*	boundingVolume;
@@ -111,6 +153,7 @@ namespace NCL::CSC8503 {
 		NetworkObject*		networkObject;
 
 		bool		isActive;
+		bool		isAIAgent;
 		int			worldID;
 		bool isColliding;
 		std::string	name;
@@ -118,6 +161,9 @@ namespace NCL::CSC8503 {
 		Vector3 broadphaseAABB;
 
 		std::vector<GameObject*> ignoreList = std::vector<GameObject*>{};
+
+		GameWorld*	world;
+		int			componentIndices[(int)ComponentType::MaxTypes];
 	};
 
 	class PlayerObject : public GameObject
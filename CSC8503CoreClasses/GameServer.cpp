@@ -1,5 +1,6 @@
 #include "GameServer.h"
-#include "GameWorld.h"
+#include "LoopbackNetwork.h"
+#include "NetworkStats.h"
 #include "./enet/enet.h"
 using namespace NCL;
 using namespace CSC8503;
@@ -9,17 +10,31 @@ GameServer::GameServer(int onPort, int maxClients)	{
 	clientMax	= maxClients;
 	clientCount = 0;
 	netHandle	= nullptr;
+	deferSends	= false;
 	Initialise();
 }
 
+GameServer::GameServer(LoopbackNetwork& network, int maxClients) {
+	port		= 0;
+	clientMax	= maxClients;
+	clientCount = 0;
+	netHandle	= nullptr;
+	deferSends	= false;
+	loopback	= &network;
+}
+
 GameServer::~GameServer()	{
 	Shutdown();
 }
 
 void GameServer::Shutdown() {
+	SetDeferredSends(false);
 	SendGlobalPacket(BasicNetworkMessages::Shutdown);
-	enet_host_destroy(netHandle);
-	netHandle = nullptr;
+	if (netHandle) {
+		enet_host_destroy(netHandle);
+	}
+	netHandle	= nullptr;
+	loopback	= nullptr;
 }
 
 bool GameServer::Initialise() 
@@ -28,7 +43,7 @@ bool GameServer::Initialise()
 	address.host = ENET_HOST_ANY;
 	address.port = port;
 
-	netHandle = enet_host_create(&address, clientMax, 1, 0, 0);
+	netHandle = enet_host_create(&address, clientMax, ChannelCount, 0, 0);
 
 	if (!netHandle)
 	{
@@ -47,38 +62,159 @@ bool GameServer::SendGlobalPacket(int msgID)
 
 bool GameServer::SendGlobalPacket(GamePacket& packet) 
 {
-	ENetPacket* dataPacket = enet_packet_create(&packet, packet.GetTotalSize(), 0);
-	enet_host_broadcast(netHandle, 0, dataPacket);
+	if (!netHandle && !loopback) {
+		return false;
+	}
+	ENetPacket* dataPacket = CreatePacket(packet);
+	if (deferSends) {
+		std::lock_guard<std::mutex> lock(deferredLock);
+		deferredSends.emplace_back(-1, dataPacket);
+		return true;
+	}
+	SendNow(-1, dataPacket);
+	return true;
+}
+
+bool GameServer::SendPacketToPeer(int peerID, GamePacket& packet) 
+{
+	if (!IsValidPeer(peerID)) {
+		return false;
+	}
+	ENetPacket* dataPacket = CreatePacket(packet);
+	if (deferSends) {
+		std::lock_guard<std::mutex> lock(deferredLock);
+		deferredSends.emplace_back(peerID, dataPacket);
+		return true;
+	}
+	SendNow(peerID, dataPacket);
 	return true;
 }
 
+bool GameServer::IsValidPeer(int peerID) const {
+	if (loopback) {
+		return peerID >= 0 && peerID < loopback->GetClientCount();
+	}
+	return netHandle && peerID >= 0 && peerID < (int)netHandle->peerCount;
+}
+
+//A peer of -1 is a broadcast
+void GameServer::SendNow(int peerID, _ENetPacket* packet) {
+	int channel = GetPacketChannel(packet);
+	stats->RecordPacket(NetworkStats::Sent, ((GamePacket*)packet->data)->type, (int)packet->dataLength);
+	if (loopback) {
+		if (peerID < 0) {
+			loopback->Broadcast(packet, channel);
+		}
+		else {
+			loopback->Send(LoopbackNetwork::ServerEndpoint, peerID, packet, channel);
+		}
+	}
+	else if (peerID < 0) {
+		enet_host_broadcast(netHandle, channel, packet);
+	}
+	else {
+		enet_peer_send(&netHandle->peers[peerID], channel, packet);
+	}
+}
+
+void GameServer::DisconnectPeer(int peerID) {
+	if (!IsValidPeer(peerID)) {
+		return;
+	}
+	if (loopback) {
+		loopback->Disconnect(peerID);
+		return;
+	}
+	enet_peer_disconnect(&netHandle->peers[peerID], 0);
+}
+
+void GameServer::SetDeferredSends(bool state) {
+	if (!state) {
+		FlushDeferredSends();
+	}
+	deferSends = state;
+}
+
+/*
+Packets go out in the order they were queued - each thread's packets
+stay in order, which is all that matters, as a peer is only ever sent
+to from one thread at a time.
+*/
+void GameServer::FlushDeferredSends() {
+	std::lock_guard<std::mutex> lock(deferredLock);
+	for (auto& [peerID, dataPacket] : deferredSends) {
+		SendNow(peerID, dataPacket);
+	}
+	deferredSends.clear();
+}
+
+/*
+Packets deferred since the last call are sent first. Connections and
+disconnections are passed on to the packet handlers as Player_Connected /
+Player_Disconnected messages, so that anything keeping per-client state
+can set it up and tear it down.
+*/
 void GameServer::UpdateServer() 
 {
+	//Anything other threads have queued up since the last update
+	FlushDeferredSends();
+	if (loopback) {
+		LoopbackNetwork::Event event;
+		while (loopback->Receive(LoopbackNetwork::ServerEndpoint, event)) {
+			OnEvent(event.type, event.peer, event.packet);
+		}
+		const LoopbackNetwork::LinkStats& upload = loopback->GetServerUploadStats();
+		stats->SetRoundTripTime(loopback->GetRoundTripTime() * 1000.0f);
+		stats->SetPacketLoss(upload.packetsSent > 0 ? (float)upload.packetsLost / upload.packetsSent : 0.0f);
+		return;
+	}
 	if (!netHandle) return;
 	ENetEvent event;
 	while (enet_host_service(netHandle, &event, 0) > 0)
 	{
-		int type = event.type;
-		ENetPeer* p = event.peer;
-		int peer = p->incomingPeerID;
+		OnEvent(event.type, event.peer->incomingPeerID, event.packet);
+	}
+	UpdatePeerStats();
+}
 
-		if (type == ENetEventType::ENET_EVENT_TYPE_CONNECT)
-		{
-			std::cout << "Server: New client connected" << std::endl;
-		}
-		else if (type == ENetEventType::ENET_EVENT_TYPE_DISCONNECT)
-		{
-			std::cout << "Server: A client has disconnected" << std::endl;
-		}
-		else if (type == ENetEventType::ENET_EVENT_TYPE_RECEIVE)
-		{
-			GamePacket* packet = (GamePacket*)event.packet->data;
-			ProcessPacket(packet, peer);
+//The server's figures are the average over every client connected
+void GameServer::UpdatePeerStats() {
+	float	roundTripTime	= 0.0f;
+	float	packetLoss		= 0.0f;
+	int		peers			= 0;
+	for (size_t i = 0; i < netHandle->peerCount; ++i) {
+		const ENetPeer& peer = netHandle->peers[i];
+		if (peer.state != ENET_PEER_STATE_CONNECTED) {
+			continue;
 		}
-		enet_packet_destroy(event.packet);
+		roundTripTime	+= (float)peer.roundTripTime;
+		packetLoss		+= (float)peer.packetLoss / (float)ENET_PEER_PACKET_LOSS_SCALE;
+		peers++;
+	}
+	if (peers > 0) {
+		stats->SetRoundTripTime(roundTripTime / peers);
+		stats->SetPacketLoss(packetLoss / peers);
 	}
 }
 
-void GameServer::SetGameWorld(GameWorld &g) {
-	gameWorld = &g;
-}
\ No newline at end of file
+void GameServer::OnEvent(int type, int peer, _ENetPacket* received)
+{
+	if (type == ENetEventType::ENET_EVENT_TYPE_CONNECT)
+	{
+		std::cout << "Server: New client connected" << std::endl;
+		clientCount++;
+		GamePacket packet(BasicNetworkMessages::Player_Connected);
+		ProcessPacket(&packet, peer);
+	}
+	else if (type == ENetEventType::ENET_EVENT_TYPE_DISCONNECT)
+	{
+		std::cout << "Server: A client has disconnected" << std::endl;
+		clientCount--;
+		GamePacket packet(BasicNetworkMessages::Player_Disconnected);
+		ProcessPacket(&packet, peer);
+	}
+	else if (type == ENetEventType::ENET_EVENT_TYPE_RECEIVE)
+	{
+		ProcessPacket(received, peer);
+	}
+}
@@ -1,29 +1,45 @@
 #pragma once
 #include "NetworkBase.h"
+#include <mutex>
 
 namespace NCL {
 	namespace CSC8503 {
-		class GameWorld;
 		class GameServer : public NetworkBase {
 		public:
 			GameServer(int onPort, int maxClients);
+			GameServer(LoopbackNetwork& network, int maxClients);
 			~GameServer();
 
 			bool Initialise();
 			void Shutdown();
 
-			void SetGameWorld(GameWorld &g);
-
 			bool SendGlobalPacket(int msgID);
 			bool SendGlobalPacket(GamePacket& packet);
+			bool SendPacketToPeer(int peerID, GamePacket& packet);
+			void DisconnectPeer(int peerID);
+
+			//ENet hosts can't be used from more than one thread at once, so while
+			//other threads are sending, packets are queued up instead, and handed
+			//over to ENet by the main thread when it calls FlushDeferredSends,
+			//or at the start of UpdateServer
+			void SetDeferredSends(bool state);
+			void FlushDeferredSends();
 
 			virtual void UpdateServer();
 
 		protected:
+			bool IsValidPeer(int peerID) const;
+			void SendNow(int peerID, _ENetPacket* packet);
+			void OnEvent(int type, int peer, _ENetPacket* received);
+			void UpdatePeerStats();
+
 			int			port;
 			int			clientMax;
 			int			clientCount;
-			GameWorld*	gameWorld;
+
+			bool		deferSends;
+			std::mutex	deferredLock;
+			std::vector<std::pair<int, _ENetPacket*>> deferredSends; //peer -1 is a broadcast
 
 			int incomingDataRate;
 			int outgoingDataRate;
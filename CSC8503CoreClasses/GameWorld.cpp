@@ -11,41 +11,136 @@ using namespace NCL::CSC8503;
 GameWorld::GameWorld()	{
 	shuffleConstraints	= false;
 	shuffleObjects		= false;
+	deterministic		= false;
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+	for (bool& b : componentListSorted) {
+		b = true;
+	}
 }
 
 GameWorld::~GameWorld()	{
+	Clear();
+}
+
+bool GameWorld::PendingRemoval::IsDeletion() const {
+	return andDelete && object->GetWorldID() < order;
 }
 
 void GameWorld::Clear() {
+	for (auto& o : gameObjects) {
+		o->world = nullptr;
+		for (int& i : o->componentIndices) {
+			i = -1;
+		}
+	}
+	for (int i = 0; i < (int)ComponentType::MaxTypes; ++i) {
+		componentLists[i].clear();
+		componentListSorted[i] = true;
+	}
 	gameObjects.clear();
 	constraints.clear();
+	for (auto& r : pendingRemovals) {
+		if (r.IsDeletion()) {
+			pendingDeletions.emplace_back(r.object);
+		}
+	}
+	pendingAdditions.clear();
+	pendingRemovals.clear();
+	//Nothing else will delete these once they're off the list
+	std::sort(pendingDeletions.begin(), pendingDeletions.end());
+	pendingDeletions.erase(std::unique(pendingDeletions.begin(), pendingDeletions.end()), pendingDeletions.end());
+	for (auto& i : pendingDeletions) {
+		delete i;
+	}
+	pendingDeletions.clear();
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
 }
 
+//An object can be on more than one of the lists, but must only be deleted once
 void GameWorld::ClearAndErase() {
-	for (auto& i : gameObjects) {
-		delete i;
-	}
+	pendingDeletions.insert(pendingDeletions.end(), gameObjects.begin(), gameObjects.end());
+	pendingDeletions.insert(pendingDeletions.end(), pendingAdditions.begin(), pendingAdditions.end());
 	for (auto& i : constraints) {
 		delete i;
 	}
+	gameObjects.clear();
+	pendingAdditions.clear();
 	Clear();
 }
 
 void GameWorld::AddGameObject(GameObject* o) {
-	gameObjects.emplace_back(o);
+	pendingAdditions.emplace_back(o);
 	o->SetWorldID(worldIDCounter++);
-	worldStateCounter++;
 }
 
 void GameWorld::RemoveGameObject(GameObject* o, bool andDelete) {
-	gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
-	if (andDelete) {
-		delete o;
+	pendingRemovals.push_back({ o, worldIDCounter, andDelete });
+}
+
+/*
+Applies every buffered addition and removal in one go. Removals are sorted
+so that an object's newest removal can be binary searched for, and the
+object list is compacted in a single pass, rather than erasing (and
+shuffling the rest of the vector down) once per object.
+Every removal is applied before any addition, so an object removed and
+then added back in the same frame (a respawn, say) ends up in the world,
+and isn't deleted, while one added and then removed never gets in at all.
+*/
+void GameWorld::SyncPendingChanges() {
+	if (pendingAdditions.empty() && pendingRemovals.empty()) {
+		return;
+	}
+	if (!pendingRemovals.empty()) {
+		std::sort(pendingRemovals.begin(), pendingRemovals.end(), [](const PendingRemoval& a, const PendingRemoval& b) {
+			return a.object != b.object ? a.object < b.object : a.order < b.order;
+		});
+		bool removedAny = false;
+		for (auto& r : pendingRemovals) {
+			GameObject* o = r.object;
+			if (o->world == this) {
+				o->world = nullptr;
+				UpdateComponentLists(o);
+				if (objectRemoved) {
+					objectRemoved(o);
+				}
+				removedAny = true;
+			}
+			if (r.IsDeletion()) {
+				pendingDeletions.emplace_back(o);
+			}
+		}
+		if (removedAny) {
+			gameObjects.erase(std::remove_if(gameObjects.begin(), gameObjects.end(),
+				[&](GameObject* o) { return o->world != this; }), gameObjects.end());
+		}
+	}
+	for (auto& o : pendingAdditions) {
+		if (o->world == this) {
+			continue; //added more than once
+		}
+		if (!pendingRemovals.empty()) {
+			auto newest = std::upper_bound(pendingRemovals.begin(), pendingRemovals.end(), o,
+				[](GameObject* o, const PendingRemoval& r) { return o < r.object; });
+			if (newest != pendingRemovals.begin() && (newest - 1)->object == o && (newest - 1)->order > o->GetWorldID()) {
+				continue; //removed again since
+			}
+		}
+		gameObjects.emplace_back(o);
+		o->world = this;
+		UpdateComponentLists(o);
 	}
+
+	std::sort(pendingDeletions.begin(), pendingDeletions.end());
+	pendingDeletions.erase(std::unique(pendingDeletions.begin(), pendingDeletions.end()), pendingDeletions.end());
+	for (auto& i : pendingDeletions) {
+		delete i;
+	}
+	pendingAdditions.clear();
+	pendingRemovals.clear();
+	pendingDeletions.clear();
+
 	worldStateCounter++;
 }
 
@@ -57,6 +152,70 @@ void GameWorld::GetObjectIterators(
 	last	= gameObjects.end();
 }
 
+void GameWorld::GetComponentIterators(
+	ComponentType type,
+	GameObjectIterator& first,
+	GameObjectIterator& last) const {
+
+	first	= componentLists[(int)type].begin();
+	last	= componentLists[(int)type].end();
+}
+
+/*
+Each component list is unordered, so membership can be changed in O(1) - 
+an object leaving a list has its slot filled by the list's last element.
+Anything saved against the old components (like a physics snapshot, which
+holds on to each body) is out of date, even if no list has changed, as a
+component may have been swapped for another of the same type.
+*/
+void GameWorld::UpdateComponentLists(GameObject* o) {
+	for (int i = 0; i < (int)ComponentType::MaxTypes; ++i) {
+		std::vector<GameObject*>& list = componentLists[i];
+		int& index = o->componentIndices[i];
+
+		bool wanted = o->world == this && o->HasComponent((ComponentType)i);
+
+		if (wanted && index < 0) {
+			index = (int)list.size();
+			list.emplace_back(o);
+			componentListSorted[i] = false;
+		}
+		else if (!wanted && index >= 0) {
+			GameObject* last = list.back();
+			list[index] = last;
+			last->componentIndices[i] = index;
+			list.pop_back();
+			index = -1;
+			componentListSorted[i] = false;
+		}
+	}
+	worldStateCounter++;
+}
+
+void GameWorld::SortComponentList(ComponentType type) {
+	std::vector<GameObject*>& list = componentLists[(int)type];
+	std::sort(list.begin(), list.end(),
+		[](const GameObject* a, const GameObject* b) { return a->GetWorldID() < b->GetWorldID(); });
+	for (int i = 0; i < (int)list.size(); ++i) {
+		list[i]->componentIndices[(int)type] = i;
+	}
+	componentListSorted[(int)type] = true;
+}
+
+void GameWorld::ShuffleComponentList(ComponentType type) {
+	std::vector<GameObject*>& list = componentLists[(int)type];
+	std::shuffle(list.begin(), list.end(), randomEngine);
+	for (int i = 0; i < (int)list.size(); ++i) {
+		list[i]->componentIndices[(int)type] = i;
+	}
+	componentListSorted[(int)type] = false;
+}
+
+void GameWorld::SetDeterministic(bool state, unsigned int seed) {
+	deterministic = state;
+	randomEngine.seed(seed);
+}
+
 void GameWorld::OperateOnContents(GameObjectFunc f) {
 	for (GameObject* g : gameObjects) {
 		f(g);
@@ -64,17 +223,28 @@ void GameWorld::OperateOnContents(GameObjectFunc f) {
 }
 
 void GameWorld::UpdateWorld(float dt) {
-	auto rng = std::default_random_engine{};
+	SyncPendingChanges();
 
-	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-	std::default_random_engine e(seed);
+	if (deterministic) {
+		for (int i = 0; i < (int)ComponentType::MaxTypes; ++i) {
+			if (!componentListSorted[i]) {
+				SortComponentList((ComponentType)i);
+			}
+		}
+	}
+	else {
+		unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+		randomEngine.seed(seed);
+	}
 
 	if (shuffleObjects) {
-		std::shuffle(gameObjects.begin(), gameObjects.end(), e);
+		std::shuffle(gameObjects.begin(), gameObjects.end(), randomEngine);
+		//The physics system walks its own list, so that needs shuffling too
+		ShuffleComponentList(ComponentType::Physics);
 	}
 
 	if (shuffleConstraints) {
-		std::shuffle(constraints.begin(), constraints.end(), e);
+		std::shuffle(constraints.begin(), constraints.end(), randomEngine);
 	}
 }
 
@@ -22,9 +22,19 @@ namespace NCL {
 			void Clear();
 			void ClearAndErase();
 
+			//Additions and removals are buffered, and only applied to the
+			//object list when SyncPendingChanges is called (once per frame,
+			//from UpdateWorld), so they're safe to make mid-iteration
 			void AddGameObject(GameObject* o);
 			void RemoveGameObject(GameObject* o, bool andDelete = false);
 
+			void SyncPendingChanges();
+
+			//Called on every object SyncPendingChanges takes out of the world, before any are deleted
+			void SetObjectRemovedCallback(GameObjectFunc f) {
+				objectRemoved = f;
+			}
+
 			void AddConstraint(Constraint* c);
 			void RemoveConstraint(Constraint* c, bool andDelete = false);
 
@@ -40,32 +50,128 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
+			//A deterministic world keeps its component lists in world ID order,
+			//shuffles with a fixed seed, and has the physics system run at a
+			//fixed rate - so identical inputs always give bit-identical state
+			void SetDeterministic(bool state, unsigned int seed = 0);
+
+			bool IsDeterministic() const {
+				return deterministic;
+			}
+
+			//Anything in the world that wants a random number should take it from here,
+			//so a deterministic world gets the same numbers every time it's run
+			std::default_random_engine& GetRandomEngine() {
+				return randomEngine;
+			}
+
 			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, GameObject* ignore = nullptr, std::vector<int> ignoreLayerList = {}) const;
 
 			virtual void UpdateWorld(float dt);
 
 			void OperateOnContents(GameObjectFunc f);
 
+			//Templated visitors - unlike the std::function version above, these
+			//can be inlined, so per-frame sweeps compile down to a plain loop
+			template <typename Func>
+			void OperateOnContents(Func&& f) {
+				for (GameObject* g : gameObjects) {
+					f(g);
+				}
+			}
+
+			template <typename Filter, typename Func>
+			void OperateOnContents(Filter&& filter, Func&& f) {
+				for (GameObject* g : gameObjects) {
+					if (filter(g)) {
+						f(g);
+					}
+				}
+			}
+
+			//Visits only the objects currently holding the given component,
+			//using the dense lists kept up to date by UpdateComponentLists
+			template <typename Func>
+			void OperateOnComponents(ComponentType type, Func&& f) {
+				const std::vector<GameObject*>& list = componentLists[(int)type];
+				for (size_t i = 0; i < list.size(); ++i) {
+					f(list[i]);
+				}
+			}
+
+			template <typename Func>
+			void OperateOnPhysicsContents(Func&& f) {
+				OperateOnComponents(ComponentType::Physics, std::forward<Func>(f));
+			}
+
+			//Only visits active objects that have a render object
+			template <typename Func>
+			void OperateOnRenderContents(Func&& f) {
+				OperateOnComponents(ComponentType::Render, std::forward<Func>(f));
+			}
+
+			template <typename Func>
+			void OperateOnNetworkContents(Func&& f) {
+				OperateOnComponents(ComponentType::Network, std::forward<Func>(f));
+			}
+
+			template <typename Func>
+			void OperateOnAIContents(Func&& f) {
+				OperateOnComponents(ComponentType::AI, std::forward<Func>(f));
+			}
+
+			//Called by GameObjects whenever a component is attached or detached
+			void UpdateComponentLists(GameObject* o);
+
 			void GetObjectIterators(
 				GameObjectIterator& first,
 				GameObjectIterator& last) const;
 
+			void GetComponentIterators(
+				ComponentType type,
+				GameObjectIterator& first,
+				GameObjectIterator& last) const;
+
 			void GetConstraintIterators(
 				std::vector<Constraint*>::const_iterator& first,
 				std::vector<Constraint*>::const_iterator& last) const;
 
+			//Changes whenever an object is added or removed, or has a component changed
 			int GetWorldStateID() const {
 				return worldStateCounter;
 			}
 
 		protected:
+			void ShuffleComponentList(ComponentType type);
+			void SortComponentList(ComponentType type);
+
 			std::vector<GameObject*> gameObjects;
 			std::vector<Constraint*> constraints;
 
+			//An object's world ID is set whenever it's added, so comparing it against the counter as
+			//it was when a removal was asked for tells which of the two happened first
+			struct PendingRemoval {
+				GameObject*	object;
+				int			order;	//worldIDCounter when it was removed
+				bool		andDelete;
+
+				//It asked for a deletion, and hasn't been added back since
+				bool IsDeletion() const;
+			};
+			std::vector<GameObject*>	pendingAdditions;
+			std::vector<PendingRemoval>	pendingRemovals;
+			std::vector<GameObject*>	pendingDeletions;
+			GameObjectFunc			 objectRemoved;
+
+			std::vector<GameObject*> componentLists[(int)ComponentType::MaxTypes];
+			bool	componentListSorted[(int)ComponentType::MaxTypes];
+
 			PerspectiveCamera mainCamera;
 
 			bool shuffleConstraints;
 			bool shuffleObjects;
+			bool deterministic;
+			std::default_random_engine randomEngine;
 			int		worldIDCounter;
 			int		worldStateCounter;
 		};
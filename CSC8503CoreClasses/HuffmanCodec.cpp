@@ -0,0 +1,151 @@
+#include "HuffmanCodec.h"
+#include "BitStream.h"
+#include <queue>
+
+using namespace NCL;
+using namespace CSC8503;
+
+HuffmanCodec::HuffmanCodec() {
+	for (int i = 0; i < SymbolCount; ++i) {
+		codeLengths[i] = 8;
+	}
+	BuildCodes();
+}
+
+HuffmanCodec::~HuffmanCodec() {
+}
+
+/*
+Symbols the table has never seen still get a weight of 1, so they can be
+encoded. If the tree comes out too deep, the weights are flattened out a
+little and it's built again - that's rare, and costs next to nothing in
+compression, as only the least likely symbols ever get long codes.
+*/
+void HuffmanCodec::Build(const uint32_t frequencies[SymbolCount]) {
+	uint64_t weights[SymbolCount];
+	for (int i = 0; i < SymbolCount; ++i) {
+		weights[i] = std::max<uint64_t>(frequencies[i], 1);
+	}
+	while (true) {
+		BuildCodeLengths(weights);
+		if (*std::max_element(codeLengths, codeLengths + SymbolCount) <= MaxCodeLength) {
+			break;
+		}
+		for (uint64_t& w : weights) {
+			w = (w + 1) / 2;
+		}
+	}
+	BuildCodes();
+}
+
+void HuffmanCodec::BuildCodeLengths(const uint64_t weights[SymbolCount]) {
+	//Leaves first, then every node made by joining the two lightest remaining
+	std::vector<uint64_t>	nodeWeights(weights, weights + SymbolCount);
+	std::vector<int>		parents(SymbolCount * 2 - 1, -1);
+
+	typedef std::pair<uint64_t, int> WeightedNode;
+	std::priority_queue<WeightedNode, std::vector<WeightedNode>, std::greater<WeightedNode>> queue;
+	for (int i = 0; i < SymbolCount; ++i) {
+		queue.push({ weights[i], i });
+	}
+	while (queue.size() > 1) {
+		WeightedNode a = queue.top(); queue.pop();
+		WeightedNode b = queue.top(); queue.pop();
+
+		int node = (int)nodeWeights.size();
+		nodeWeights.push_back(a.first + b.first);
+		parents[a.second] = node;
+		parents[b.second] = node;
+		queue.push({ a.first + b.first, node });
+	}
+	for (int i = 0; i < SymbolCount; ++i) {
+		int depth = 0;
+		for (int node = i; parents[node] >= 0; node = parents[node]) {
+			depth++;
+		}
+		codeLengths[i] = (uint8_t)depth;
+	}
+}
+
+/*
+Canonical codes - the lengths are all that's needed to rebuild them. Codes
+of each length count up in symbol order, following on from the last code
+of the length before.
+*/
+void HuffmanCodec::BuildCodes() {
+	for (int len = 0; len <= MaxCodeLength; ++len) {
+		lengthCounts[len] = 0;
+	}
+	for (int i = 0; i < SymbolCount; ++i) {
+		lengthCounts[codeLengths[i]]++;
+	}
+	int nextCode[MaxCodeLength + 2];
+	int nextIndex[MaxCodeLength + 2];
+	int code	= 0;
+	int index	= 0;
+	for (int len = 1; len <= MaxCodeLength; ++len) {
+		nextCode[len]	= code;
+		nextIndex[len]	= index;
+		code			= (code + lengthCounts[len]) << 1;
+		index			+= lengthCounts[len];
+	}
+	for (int i = 0; i < SymbolCount; ++i) {
+		int len = codeLengths[i];
+		uint32_t c = (uint32_t)nextCode[len]++;
+		uint32_t reversed = 0;
+		for (int b = 0; b < len; ++b) {
+			reversed |= ((c >> b) & 1) << (len - 1 - b);
+		}
+		codes[i] = (uint16_t)reversed;
+		sortedSymbols[nextIndex[len]++] = (uint8_t)i;
+	}
+}
+
+void HuffmanCodec::CountSymbols(const char* data, int byteCount, uint32_t frequencies[SymbolCount]) {
+	for (int i = 0; i < byteCount; ++i) {
+		frequencies[(uint8_t)data[i]]++;
+	}
+}
+
+int HuffmanCodec::GetEncodedBits(const char* data, int byteCount) const {
+	int bits = 0;
+	for (int i = 0; i < byteCount; ++i) {
+		bits += codeLengths[(uint8_t)data[i]];
+	}
+	return bits;
+}
+
+void HuffmanCodec::Encode(const char* data, int byteCount, BitWriter& stream) const {
+	for (int i = 0; i < byteCount; ++i) {
+		uint8_t symbol = (uint8_t)data[i];
+		stream.WriteBits(codes[symbol], codeLengths[symbol]);
+	}
+}
+
+/*
+A bit at a time - first is the first code of the current length, and
+index is where that length's symbols start in sortedSymbols.
+*/
+bool HuffmanCodec::Decode(BitReader& stream, char* data, int byteCount) const {
+	for (int i = 0; i < byteCount; ++i) {
+		int code	= 0;
+		int first	= 0;
+		int index	= 0;
+		int len		= 1;
+		for (; len <= MaxCodeLength; ++len) {
+			code |= (int)stream.ReadBits(1);
+			int count = lengthCounts[len];
+			if (code - first < count) {
+				data[i] = (char)sortedSymbols[index + code - first];
+				break;
+			}
+			index	+= count;
+			first	= (first + count) << 1;
+			code	<<= 1;
+		}
+		if (len > MaxCodeLength || stream.HasOverflowed()) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		class BitWriter;
+		class BitReader;
+
+		/*
+		A static, canonical Huffman code over bytes. Both ends of a connection
+		build it from the same table of byte frequencies - usually counted
+		from recorded traffic ahead of time - so nothing about the code has
+		to be sent. Every byte gets a code, even ones the table has never seen,
+		so anything can be encoded, and no code is longer than MaxCodeLength.
+
+		Codes are written most significant bit first, one bit at a time, so
+		they decode with nothing more than BitReader::ReadBits.
+		*/
+		class HuffmanCodec {
+		public:
+			static const int SymbolCount	= 256;
+			static const int MaxCodeLength	= 15;
+
+			//Every byte 8 bits long until Build is called
+			HuffmanCodec();
+			~HuffmanCodec();
+
+			void Build(const uint32_t frequencies[SymbolCount]);
+
+			//Adds each byte of data to a table of frequencies, for Build
+			static void CountSymbols(const char* data, int byteCount, uint32_t frequencies[SymbolCount]);
+
+			int  GetEncodedBits(const char* data, int byteCount) const;
+			void Encode(const char* data, int byteCount, BitWriter& stream) const;
+			//Fails if the stream runs out before byteCount bytes have been decoded
+			bool Decode(BitReader& stream, char* data, int byteCount) const;
+
+			int GetCodeLength(uint8_t symbol) const {
+				return codeLengths[symbol];
+			}
+
+		protected:
+			void BuildCodeLengths(const uint64_t weights[SymbolCount]);
+			void BuildCodes();
+
+			uint8_t		codeLengths[SymbolCount];
+			uint16_t	codes[SymbolCount];		//bit reversed, as BitWriter writes least significant bit first
+
+			//For decoding - how many codes there are of each length, and the symbols in code order
+			uint16_t	lengthCounts[MaxCodeLength + 1];
+			uint8_t		sortedSymbols[SymbolCount];
+		};
+	}
+}
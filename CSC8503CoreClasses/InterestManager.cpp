@@ -0,0 +1,91 @@
+#include "InterestManager.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "NetworkObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+InterestManager::InterestManager(float relevantRadius) {
+	this->relevantRadius	= relevantRadius;
+	worldSize				= Vector2(1024, 1024);
+	gridWidth				= 0;
+	gridDepth				= 0;
+	cellSize				= relevantRadius;
+}
+
+InterestManager::~InterestManager() {
+}
+
+static bool CompareNetworkIDs(const GameObject* a, const GameObject* b) {
+	return a->GetNetworkObject()->GetNetworkID() < b->GetNetworkObject()->GetNetworkID();
+}
+
+int InterestManager::GetCellX(float x) const {
+	return std::clamp((int)std::floor((x + worldSize.x) / cellSize), 0, gridWidth - 1);
+}
+
+int InterestManager::GetCellZ(float z) const {
+	return std::clamp((int)std::floor((z + worldSize.y) / cellSize), 0, gridDepth - 1);
+}
+
+void InterestManager::Update(GameWorld& world) {
+	cellSize	= std::max(relevantRadius, 1.0f);
+	gridWidth	= std::max(1, (int)std::ceil(worldSize.x * 2.0f / cellSize));
+	gridDepth	= std::max(1, (int)std::ceil(worldSize.y * 2.0f / cellSize));
+
+	allObjects.clear();
+	world.OperateOnNetworkContents([&](GameObject* o) {
+		allObjects.emplace_back(o);
+	});
+	std::sort(allObjects.begin(), allObjects.end(), CompareNetworkIDs);
+
+	//Count each cell's objects, add the counts up into where each cell ends, then fill
+	//the cells in from the back - each cell's end has counted down to its start by the time
+	//it's full, and going through allObjects backwards leaves every cell in ID order
+	int cellCount = gridWidth * gridDepth;
+	cellStarts.assign(cellCount + 1, 0);
+	objectCells.resize(allObjects.size());
+	for (size_t i = 0; i < allObjects.size(); ++i) {
+		Vector3 position	= allObjects[i]->GetTransform().GetPosition();
+		objectCells[i]		= GetCellZ(position.z) * gridWidth + GetCellX(position.x);
+		cellStarts[objectCells[i]]++;
+	}
+	for (int c = 1; c < cellCount; ++c) {
+		cellStarts[c] += cellStarts[c - 1];
+	}
+	cellStarts[cellCount] = (int)allObjects.size();
+
+	cellObjects.resize(allObjects.size());
+	cellPositions.resize(allObjects.size());
+	for (size_t i = allObjects.size(); i-- > 0;) {
+		int slot = --cellStarts[objectCells[i]];
+		cellObjects[slot]	= allObjects[i];
+		cellPositions[slot] = allObjects[i]->GetTransform().GetPosition();
+	}
+}
+
+void InterestManager::GetNearObjects(const Vector3& viewpoint, std::vector<GameObject*>& nearObjects) const {
+	nearObjects.clear();
+	if (cellObjects.empty()) {
+		return;
+	}
+	int minX = GetCellX(viewpoint.x - relevantRadius);
+	int maxX = GetCellX(viewpoint.x + relevantRadius);
+	int minZ = GetCellZ(viewpoint.z - relevantRadius);
+	int maxZ = GetCellZ(viewpoint.z + relevantRadius);
+
+	float radiusSquared = relevantRadius * relevantRadius;
+	for (int z = minZ; z <= maxZ; ++z) {
+		for (int x = minX; x <= maxX; ++x) {
+			int cell = z * gridWidth + x;
+			for (int i = cellStarts[cell]; i < cellStarts[cell + 1]; ++i) {
+				if ((cellPositions[i] - viewpoint).LengthSquared() <= radiusSquared) {
+					nearObjects.emplace_back(cellObjects[i]);
+				}
+			}
+		}
+	}
+	//Each cell is in order already, but not the cells put together
+	std::sort(nearObjects.begin(), nearObjects.end(), CompareNetworkIDs);
+}
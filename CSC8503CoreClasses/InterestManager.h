@@ -0,0 +1,65 @@
+#pragma once
+#include "Vector2.h"
+#include "Vector3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		class GameObject;
+		class GameWorld;
+
+		/*
+		Keeps a spatial index of the networked objects, so that the server can
+		quickly find what's within relevantRadius of each client's viewpoint.
+		The index is a fixed grid of cells relevantRadius wide, so a query only
+		ever looks at the 3x3 cells around the viewpoint. Objects are bucketed
+		into the cells with a counting sort into vectors that are kept between
+		ticks, so rebuilding it doesn't allocate once the object count settles.
+		Objects outside the world size go in the nearest edge cell.
+		*/
+		class InterestManager {
+		public:
+			InterestManager(float relevantRadius = 50.0f);
+			~InterestManager();
+
+			//Half the width / depth of the area the spatial index covers, centred on the origin
+			void SetWorldSize(const Vector2& halfSize) {
+				worldSize = halfSize;
+			}
+
+			//Rebuilds the spatial index of networked objects, once per tick. Positions are
+			//copied in, so queries can run on another thread while the world moves on.
+			void Update(GameWorld& world);
+
+			//Every networked object, in network ID order
+			const std::vector<GameObject*>& GetAllObjects() const {
+				return allObjects;
+			}
+
+			//Objects within relevantRadius of the viewpoint, in network ID order
+			void GetNearObjects(const Vector3& viewpoint, std::vector<GameObject*>& nearObjects) const;
+
+			float GetRelevantRadius() const {
+				return relevantRadius;
+			}
+
+		protected:
+			int GetCellX(float x) const;
+			int GetCellZ(float z) const;
+
+			std::vector<GameObject*>	allObjects;
+
+			//Cell c holds cellObjects[cellStarts[c]] up to cellObjects[cellStarts[c + 1]], in network ID order
+			std::vector<int>			cellStarts;
+			std::vector<GameObject*>	cellObjects;
+			std::vector<Vector3>		cellPositions;
+			std::vector<int>			objectCells;	//which cell each of allObjects is in
+			int		gridWidth;
+			int		gridDepth;
+			float	cellSize;
+
+			Vector2 worldSize;
+			float	relevantRadius;
+		};
+	}
+}
@@ -0,0 +1,175 @@
+#include "LagCompensator.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+LagCompensator::LagCompensator(int tickCount, int objectCapacity) {
+	ticks.resize(tickCount);
+	for (TickRecord& t : ticks) {
+		t.objects.reserve(objectCapacity);
+	}
+	newestTick = -1;
+}
+
+LagCompensator::~LagCompensator() {
+}
+
+void LagCompensator::Record(int stateID, GameWorld& world) {
+	TickRecord& t = ticks[stateID % ticks.size()];
+	t.stateID = stateID;
+	t.objects.clear();
+
+	world.OperateOnNetworkContents([&](GameObject* o) {
+		Vector3 halfSize;
+		if (!o->GetBroadphaseAABB(halfSize)) {
+			return;
+		}
+		const Transform& transform = o->GetTransform();
+		t.objects.push_back({ o, o->GetWorldID(), transform.GetPosition(), transform.GetOrientation(),
+			transform.GetPosition() - halfSize, transform.GetPosition() + halfSize });
+	});
+	//Already in order if the world is deterministic, so this is usually just a check
+	std::sort(t.objects.begin(), t.objects.end(),
+		[](const ObjectRecord& a, const ObjectRecord& b) { return a.worldID < b.worldID; });
+	newestTick = std::max(newestTick, stateID);
+}
+
+void LagCompensator::RemoveObject(GameObject* object) {
+	for (TickRecord& t : ticks) {
+		t.objects.erase(std::remove_if(t.objects.begin(), t.objects.end(),
+			[&](const ObjectRecord& o) { return o.object == object; }), t.objects.end());
+	}
+}
+
+int LagCompensator::GetOldestTick() const {
+	if (newestTick < 0) {
+		return -1;
+	}
+	int oldest = newestTick;
+	while (oldest > 0 && newestTick - oldest < (int)ticks.size() - 1 && GetTick(oldest - 1)) {
+		oldest--;
+	}
+	return oldest;
+}
+
+const LagCompensator::TickRecord* LagCompensator::GetTick(int stateID) const {
+	if (stateID < 0) {
+		return nullptr;
+	}
+	const TickRecord& t = ticks[stateID % ticks.size()];
+	return t.stateID == stateID ? &t : nullptr;
+}
+
+const LagCompensator::ObjectRecord* LagCompensator::FindObject(const TickRecord& t, const GameObject* object) const {
+	auto i = std::lower_bound(t.objects.begin(), t.objects.end(), object->GetWorldID(),
+		[](const ObjectRecord& o, int worldID) { return o.worldID < worldID; });
+	return (i != t.objects.end() && i->object == object) ? &(*i) : nullptr;
+}
+
+static bool IsIgnored(const GameObject* o, const GameObject* ignoreThis, const std::vector<int>& ignoreLayerList) {
+	if (o == ignoreThis || !o->GetBoundingVolume()) {
+		return true;
+	}
+	for (int layer : ignoreLayerList) {
+		if (o->GetBoundingVolume()->collisionLayer == layer) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+Objects are interpolated between the two recorded ticks either side of
+viewTick, just as the client did when drawing them. The recorded objects
+are gone through one by one, each tested against the box covering both
+of its recorded AABBs - a linear scan, but of a few hundred boxes at most,
+and only the few the ray could actually touch get moved back in time for
+the proper narrow phase test, and then put straight back again. Anything
+without a record at the earlier tick, like an object spawned since, is
+tested where it is now along with the non-networked objects.
+*/
+bool LagCompensator::Raycast(const Ray& r, float viewTick, GameWorld& world, RayCollision& closestCollision,
+	GameObject* ignoreThis, const std::vector<int>& ignoreLayerList) {
+	RayCollision collision;
+
+	const TickRecord*	from	= nullptr;
+	const TickRecord*	to		= nullptr;
+	float				t		= 0.0f;
+	int oldestTick = GetOldestTick();
+	if (oldestTick >= 0) {
+		viewTick	= std::clamp(viewTick, (float)oldestTick, (float)newestTick);
+		int fromID	= (int)viewTick;
+		t			= viewTick - fromID;
+		from		= GetTick(fromID);
+		to			= GetTick(std::min(fromID + 1, newestTick));
+	}
+
+	world.OperateOnContents([&](GameObject* o) {
+		if (IsIgnored(o, ignoreThis, ignoreLayerList)) {
+			return;
+		}
+		if (o->GetNetworkObject() && from && FindObject(*from, o)) {
+			return; //rewound below
+		}
+		RayCollision thisCollision;
+		if (CollisionDetection::RayIntersection(r, *o, thisCollision) && thisCollision.rayDistance < collision.rayDistance) {
+			thisCollision.node	= o;
+			collision			= thisCollision;
+		}
+	});
+
+	if (from) {
+		for (const ObjectRecord& a : from->objects) {
+			if (IsIgnored(a.object, ignoreThis, ignoreLayerList)) {
+				continue;
+			}
+			//Gone by the later tick means it stays where it was
+			const ObjectRecord* b = to ? FindObject(*to, a.object) : nullptr;
+			if (!b) {
+				b = &a;
+			}
+			Vector3 boundsMin(std::min(a.boundsMin.x, b->boundsMin.x), std::min(a.boundsMin.y, b->boundsMin.y), std::min(a.boundsMin.z, b->boundsMin.z));
+			Vector3 boundsMax(std::max(a.boundsMax.x, b->boundsMax.x), std::max(a.boundsMax.y, b->boundsMax.y), std::max(a.boundsMax.z, b->boundsMax.z));
+
+			Vector3 origin = r.GetPosition();
+			bool startsInside =
+				origin.x >= boundsMin.x && origin.y >= boundsMin.y && origin.z >= boundsMin.z &&
+				origin.x <= boundsMax.x && origin.y <= boundsMax.y && origin.z <= boundsMax.z;
+
+			if (!startsInside) {
+				RayCollision boundsCollision;
+				if (!CollisionDetection::RayBoxIntersection(r, (boundsMin + boundsMax) * 0.5f, (boundsMax - boundsMin) * 0.5f, boundsCollision)) {
+					continue;
+				}
+				if (boundsCollision.rayDistance >= collision.rayDistance) {
+					continue; //can't be any closer than what we've already hit
+				}
+			}
+			Quaternion toOrientation = b->orientation;
+			if (Quaternion::Dot(a.orientation, toOrientation) < 0.0f) {
+				toOrientation = toOrientation * -1.0f;
+			}
+			Transform& transform		= a.object->GetTransform();
+			Vector3 currentPosition		= transform.GetPosition();
+			Quaternion currentOrientation = transform.GetOrientation();
+
+			transform.SetPosition(a.position + (b->position - a.position) * t);
+			transform.SetOrientation(Quaternion::Slerp(a.orientation, toOrientation, t));
+
+			RayCollision thisCollision;
+			if (CollisionDetection::RayIntersection(r, *a.object, thisCollision) && thisCollision.rayDistance < collision.rayDistance) {
+				thisCollision.node	= a.object;
+				collision			= thisCollision;
+			}
+			transform.SetPosition(currentPosition);
+			transform.SetOrientation(currentOrientation);
+		}
+	}
+	if (collision.node) {
+		closestCollision = collision;
+		return true;
+	}
+	return false;
+}
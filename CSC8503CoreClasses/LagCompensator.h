@@ -0,0 +1,55 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL::CSC8503 {
+	class GameObject;
+	class GameWorld;
+
+	/*
+	Server side history of where every networked object was over the last
+	few ticks, so that a raycast can be checked against what a client was
+	actually looking at when it fired, rather than where things have moved
+	to by the time its input arrives.
+	*/
+	class LagCompensator {
+	public:
+		LagCompensator(int tickCount = 32, int objectCapacity = 256);
+		~LagCompensator();
+
+		//Called by the server once per tick, with that tick's state ID
+		void Record(int stateID, GameWorld& world);
+		//Called by the server before an object is deleted, so the history can't point at it
+		void RemoveObject(GameObject* object);
+
+		int GetOldestTick() const;
+		int GetNewestTick() const {
+			return newestTick;
+		}
+
+		//Networked objects are tested where they were at viewTick (a fractional
+		//state ID, clamped to the history), everything else where it is now -
+		//including networked objects that didn't exist yet at viewTick
+		bool Raycast(const Ray& r, float viewTick, GameWorld& world, RayCollision& closestCollision,
+			GameObject* ignoreThis = nullptr, const std::vector<int>& ignoreLayerList = {});
+
+	protected:
+		struct ObjectRecord {
+			GameObject*	object;
+			int			worldID;
+			Vector3		position;
+			Quaternion	orientation;
+			Vector3		boundsMin;
+			Vector3		boundsMax;
+		};
+		struct TickRecord {
+			int							stateID = -1;
+			std::vector<ObjectRecord>	objects;	//in world ID order
+		};
+
+		const TickRecord*	GetTick(int stateID) const;
+		const ObjectRecord* FindObject(const TickRecord& t, const GameObject* object) const;
+
+		std::vector<TickRecord> ticks;
+		int newestTick;
+	};
+}
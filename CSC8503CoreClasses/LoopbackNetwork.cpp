@@ -0,0 +1,162 @@
+#include "LoopbackNetwork.h"
+#include "./enet/enet.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+const float	maxQueueDelay	= 0.25f;	//a capped link drops packets rather than have them wait longer than this to go out
+const int	maxResends		= 32;		//ENet gives up on a peer after about this many, but the loopback never does
+
+LoopbackNetwork::LoopbackNetwork(unsigned int seed) : random(seed) {
+	time = 0.0f;
+}
+
+LoopbackNetwork::~LoopbackNetwork() {
+	auto destroyAll = [](Endpoint& e) {
+		for (auto& [arrival, message] : e.incoming) {
+			if (message.packet) {
+				enet_packet_destroy(message.packet);
+			}
+		}
+		e.incoming.clear();
+	};
+	destroyAll(server);
+	for (Endpoint& c : clients) {
+		destroyAll(c);
+	}
+}
+
+void LoopbackNetwork::SetLinkSettings(const LinkSettings& toServer, const LinkSettings& toClients) {
+	settings[0] = toClients;
+	settings[1] = toServer;
+}
+
+void LoopbackNetwork::Update(float dt) {
+	time += dt;
+}
+
+LoopbackNetwork::Endpoint& LoopbackNetwork::GetEndpoint(int endpoint) {
+	return endpoint == ServerEndpoint ? server : clients[endpoint];
+}
+
+int LoopbackNetwork::Connect() {
+	int client = (int)clients.size();
+	clients.emplace_back();
+	clients[client].connected = true;
+
+	LinkSettings reliable;
+	reliable.latency = settings[1].latency;
+	Post(client, ServerEndpoint, ENET_EVENT_TYPE_CONNECT, nullptr, -1, reliable);
+	reliable.latency = settings[0].latency;
+	Post(ServerEndpoint, client, ENET_EVENT_TYPE_CONNECT, nullptr, -1, reliable);
+	return client;
+}
+
+void LoopbackNetwork::Disconnect(int client) {
+	if (client < 0 || client >= (int)clients.size() || !clients[client].connected) {
+		return;
+	}
+	clients[client].connected = false;
+
+	LinkSettings reliable;
+	reliable.latency = settings[1].latency;
+	Post(client, ServerEndpoint, ENET_EVENT_TYPE_DISCONNECT, nullptr, -1, reliable);
+	reliable.latency = settings[0].latency;
+	Post(ServerEndpoint, client, ENET_EVENT_TYPE_DISCONNECT, nullptr, -1, reliable);
+}
+
+void LoopbackNetwork::Send(int from, int to, _ENetPacket* packet, int channel) {
+	if (from < ServerEndpoint || from >= (int)clients.size() || to < ServerEndpoint || to >= (int)clients.size()) {
+		enet_packet_destroy(packet);
+		return;
+	}
+	int					direction	= to == ServerEndpoint ? 1 : 0;
+	const LinkSettings& link		= settings[direction];
+	LinkStats&			s			= stats[direction];
+	s.packetsSent++;
+	s.bytesSent += (int)packet->dataLength;
+
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	float resendDelay = 0.0f;
+	for (int i = 0; i < maxResends && chance(random) < link.loss; ++i) {
+		if (!(packet->flags & ENET_PACKET_FLAG_RELIABLE)) {
+			s.packetsLost++;
+			enet_packet_destroy(packet);
+			return;
+		}
+		s.packetsResent++;
+		resendDelay += 2.0f * link.latency + link.jitter; //ENet waits about a round trip before resending
+	}
+	Post(from, to, ENET_EVENT_TYPE_RECEIVE, packet, channel, link, resendDelay);
+}
+
+void LoopbackNetwork::Broadcast(_ENetPacket* packet, int channel) {
+	for (int i = 0; i < (int)clients.size(); ++i) {
+		if (clients[i].connected) {
+			Send(ServerEndpoint, i, enet_packet_create(packet->data, packet->dataLength, packet->flags), channel);
+		}
+	}
+	enet_packet_destroy(packet);
+}
+
+/*
+A bandwidth cap is modelled as a queue at the client's end of the link,
+one each way: each packet goes out once the ones before it have, taking
+as long as its size needs, then spends the latency (and jitter) getting
+there.
+*/
+void LoopbackNetwork::Post(int from, int to, int type, _ENetPacket* packet, int channel, const LinkSettings& link, float delay) {
+	Endpoint& sender = GetEndpoint(from);
+	Endpoint& target = GetEndpoint(to);
+
+	float departure = time;
+	if (packet && link.bandwidth > 0) {
+		float& freeAt = to == ServerEndpoint ? sender.uploadFreeAt : target.downloadFreeAt;
+		float start = std::max(time, freeAt);
+		if (start - time > maxQueueDelay) {
+			stats[to == ServerEndpoint ? 1 : 0].packetsLost++;
+			enet_packet_destroy(packet);
+			return;
+		}
+		departure	= start + (float)packet->dataLength / link.bandwidth;
+		freeAt		= departure;
+	}
+	float jitter	= link.jitter > 0.0f ? std::uniform_real_distribution<float>(0.0f, link.jitter)(random) : 0.0f;
+	float arrival	= departure + link.latency + jitter + delay;
+
+	if (!packet || (packet->flags & ENET_PACKET_FLAG_RELIABLE)) {
+		float& last = target.lastReliable[{from, channel}];
+		arrival = std::max(arrival, last); //held back until everything before it has arrived
+		last	= arrival;
+	}
+	Message m;
+	m.type		= type;
+	m.from		= from;
+	m.channel	= channel;
+	m.sequence	= sender.nextSequence++;
+	m.packet	= packet;
+	target.incoming.emplace(arrival, m);
+}
+
+bool LoopbackNetwork::Receive(int endpoint, Event& e) {
+	Endpoint& target = GetEndpoint(endpoint);
+	while (!target.incoming.empty() && target.incoming.begin()->first <= time) {
+		Message m = target.incoming.begin()->second;
+		target.incoming.erase(target.incoming.begin());
+
+		if (m.packet && !(m.packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED))) {
+			auto last = target.lastDelivered.find({ m.from, m.channel });
+			if (last != target.lastDelivered.end() && m.sequence < last->second) {
+				stats[endpoint == ServerEndpoint ? 1 : 0].packetsStale++;
+				enet_packet_destroy(m.packet);
+				continue;
+			}
+			target.lastDelivered[{ m.from, m.channel }] = m.sequence;
+		}
+		e.type		= m.type;
+		e.peer		= endpoint == ServerEndpoint ? m.from : 0;
+		e.packet	= m.packet;
+		return true;
+	}
+	return false;
+}
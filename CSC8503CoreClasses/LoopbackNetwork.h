@@ -0,0 +1,115 @@
+#pragma once
+#include <random>
+
+struct _ENetPacket;
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Stands in for the real network, so a server and any number of clients
+		can all run in the one process, with no sockets. Packets are held
+		back for the link's latency plus some random jitter, dropped at the
+		link's loss rate, and queued up behind each other if the link has a
+		bandwidth cap. Channels behave as they do in ENet - reliable packets
+		are never lost, just resent a round trip later, and always arrive in
+		order. Sequenced packets that arrive after a newer one on the same
+		channel are thrown away.
+
+		Time only moves when Update is called, so a test can run as fast as
+		the machine allows, and with the same seed, the same packets are lost
+		every run.
+		*/
+		class LoopbackNetwork {
+		public:
+			struct LinkSettings {
+				float	latency		= 0.0f;	//seconds, one way
+				float	jitter		= 0.0f;	//up to this many seconds extra, at random
+				float	loss		= 0.0f;	//0 to 1
+				int		bandwidth	= 0;	//bytes per second each client's connection can carry, 0 for no cap
+			};
+
+			struct LinkStats {
+				int	packetsSent		= 0;
+				int	bytesSent		= 0;
+				int	packetsLost		= 0;	//at random, or because the link's queue was full
+				int	packetsStale	= 0;	//arrived after a newer packet, so thrown away
+				int	packetsResent	= 0;	//reliable packets that were lost, and sent again
+			};
+
+			//What a server or client gets out of Receive - the type is an ENetEventType
+			struct Event {
+				int				type;
+				int				peer;	//server: the client it's from. client: always 0
+				_ENetPacket*	packet;
+			};
+
+			static const int ServerEndpoint = -1; //clients are 0 upwards, the same as their peer ID on the server
+
+			LoopbackNetwork(unsigned int seed = 0);
+			~LoopbackNetwork();
+
+			void SetLinkSettings(const LinkSettings& toServer, const LinkSettings& toClients);
+
+			void	Update(float dt);
+			float	GetTime() const {
+				return time;
+			}
+
+			//Returns the new client's endpoint - both ends get a connect event, a trip's latency later
+			int		Connect();
+			//Either end can hang up, and both ends get a disconnect event
+			void	Disconnect(int client);
+			//Every client that has ever connected, so one more than the highest client endpoint
+			int		GetClientCount() const {
+				return (int)clients.size();
+			}
+
+			//Takes ownership of the packet
+			void	Send(int from, int to, _ENetPacket* packet, int channel);
+			void	Broadcast(_ENetPacket* packet, int channel);
+			bool	Receive(int endpoint, Event& e);
+
+			const LinkStats& GetServerUploadStats() const {
+				return stats[0];
+			}
+			const LinkStats& GetServerDownloadStats() const {
+				return stats[1];
+			}
+			//Seconds there and back, with the average jitter each way
+			float GetRoundTripTime() const {
+				return settings[0].latency + settings[1].latency + 0.5f * (settings[0].jitter + settings[1].jitter);
+			}
+
+		protected:
+			struct Message {
+				int				type;
+				int				from;
+				int				channel;
+				int				sequence;
+				_ENetPacket*	packet;
+			};
+			typedef std::pair<int, int> SenderChannel;
+
+			struct Endpoint {
+				bool	connected		= false;
+				float	uploadFreeAt	= 0.0f;	//when a client's connection queues empty, with a bandwidth cap
+				float	downloadFreeAt	= 0.0f;
+				int		nextSequence	= 0;
+				std::map<SenderChannel, int>	lastDelivered;		//newest sequenced packet received
+				std::map<SenderChannel, float>	lastReliable;		//when the newest reliable packet will arrive
+				std::multimap<float, Message>	incoming;		//by arrival time
+			};
+
+			Endpoint&	GetEndpoint(int endpoint);
+			void		Post(int from, int to, int type, _ENetPacket* packet, int channel, const LinkSettings& link, float delay = 0.0f);
+
+			float			time;
+			std::mt19937	random;
+			LinkSettings	settings[2];	//towards the clients, then towards the server
+			LinkStats		stats[2];
+
+			Endpoint				server;
+			std::vector<Endpoint>	clients;
+		};
+	}
+}
@@ -1,13 +1,26 @@
 #include "NetworkBase.h"
+#include "NetworkStats.h"
 #include "./enet/enet.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
 NetworkBase::NetworkBase()	{
-	netHandle = nullptr;
+	netHandle			= nullptr;
+	loopback			= nullptr;
+	loopbackEndpoint	= -1;
+	invalidPackets		= 0;
+	stats				= new NetworkStats();
+	for (int i = 0; i < MaxMessageTypes; ++i) {
+		minimumSizes[i] = 0;
+	}
 }
 
 NetworkBase::~NetworkBase()	{
 	if (netHandle) {
 		enet_host_destroy(netHandle);
 	}
+	delete stats;
 }
 
 void NetworkBase::Initialise() {
@@ -18,20 +31,79 @@ void NetworkBase::Destroy() {
 	enet_deinitialize();
 }
 
-bool NetworkBase::ProcessPacket(GamePacket* packet, int peerID) 
-{
-	PacketHandlerIterator firstHanldler;
-	PacketHandlerIterator lastHandler;
+int NetworkBase::GetChannel(int msgID) {
+	switch (msgID) {
+		case Delta_State:
+		case Full_State:
+		case Snapshot_State:
+		case Player_State:
+			return Channel_State;
+		case Received_State:
+			return Channel_Input;
+		default:
+			return Channel_Events;
+	}
+}
 
-	bool canHandle = GetPacketHandlers(packet->type, firstHanldler, lastHandler);
-	if (canHandle)
+_ENetPacket* NetworkBase::CreatePacket(GamePacket& packet) {
+	enet_uint32 flags = 0;
+	switch (GetChannel(packet.type)) {
+		case Channel_Events:	flags = ENET_PACKET_FLAG_RELIABLE;		break;
+		case Channel_Input:		flags = ENET_PACKET_FLAG_UNSEQUENCED;	break;
+	}
+	return enet_packet_create(&packet, packet.GetTotalSize(), flags);
+}
+
+int NetworkBase::GetPacketChannel(_ENetPacket* packet) {
+	return GetChannel(((GamePacket*)packet->data)->type);
+}
+
+/*
+Returns true if a handler has taken ownership of the ENet packet. Every
+handler still sees the payload, even after one of them has kept it.
+*/
+bool NetworkBase::ProcessPacket(GamePacket* packet, int peerID, _ENetPacket* owner) 
+{
+	if (packet->type < 0 || packet->type >= MaxMessageTypes || packetHandlers[packet->type].empty())
 	{
-		for (auto i = firstHanldler; i != lastHandler; i++)
-		{
-			i->second->ReceivePacket(packet->type, packet, peerID);
+		stats->RecordUnhandled(); //printing here costs far more than the packet itself
+		return false;
+	}
+	bool kept = false;
+	for (PacketReceiver* r : packetHandlers[packet->type])
+	{
+		if (owner && !kept) {
+			kept = r->ReceiveOwnedPacket(packet->type, packet, owner, peerID);
+		}
+		else {
+			r->ReceivePacket(packet->type, packet, peerID);
 		}
-		return true;
 	}
-	std::cout << __FUNCTION__ << " no handler for packet type " << packet->type << std::endl;
-	return false;
+	return kept;
+}
+
+void NetworkBase::ProcessPacket(_ENetPacket* packet, int peerID) 
+{
+	GamePacket* view = GetPacketView(packet->data, packet->dataLength);
+	if (view) {
+		stats->RecordPacket(NetworkStats::Received, view->type, (int)packet->dataLength);
+	}
+	if (!view || !ProcessPacket(view, peerID, packet)) {
+		enet_packet_destroy(packet);
+	}
+}
+
+GamePacket* NetworkBase::GetPacketView(unsigned char* data, size_t length) 
+{
+	if (length < sizeof(GamePacket)) {
+		invalidPackets++;
+		return nullptr;
+	}
+	GamePacket* packet = (GamePacket*)data;
+	if (packet->size < 0 || sizeof(GamePacket) + packet->size > length ||
+		(packet->type >= 0 && packet->type < MaxMessageTypes && packet->size < minimumSizes[packet->type])) {
+		invalidPackets++;
+		return nullptr;
+	}
+	return packet;
 }
\ No newline at end of file
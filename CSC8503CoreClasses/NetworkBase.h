@@ -3,6 +3,14 @@
 struct _ENetHost;
 struct _ENetPeer;
 struct _ENetEvent;
+struct _ENetPacket;
+
+namespace NCL {
+	namespace CSC8503 {
+		class LoopbackNetwork;
+		class NetworkStats;
+	}
+}
 
 enum BasicNetworkMessages {
 	None,
@@ -14,7 +22,22 @@ enum BasicNetworkMessages {
 	Received_State, //received from a client, informs that its received packet n
 	Player_Connected,
 	Player_Disconnected,
-	Shutdown
+	Shutdown,
+	Snapshot_State,	//a whole tick's worth of Delta_State / Full_State packets
+	Player_State,	//a client's own player, exactly as the server simulated it
+	Spawn_State,	//objects that have appeared or gone since the last one, with the state they start in
+	MessageTypeCount	//not a message - keep it last, so loops over every type stay in step
+};
+
+/*
+Each kind of message has its own ENet channel, so that a lost snapshot
+never holds up an event, or the other way round.
+*/
+enum NetworkChannel {
+	Channel_State,	//unreliable and sequenced - anything older than what's already arrived is dropped
+	Channel_Events,	//reliable and ordered
+	Channel_Input,	//unreliable and unsequenced - every input that arrives is worth having
+	ChannelCount
 };
 
 struct GamePacket {
@@ -58,6 +81,14 @@ struct StringPacket : public GamePacket
 class PacketReceiver {
 public:
 	virtual void ReceivePacket(int type, GamePacket* payload, int source = -1) = 0;
+
+	//Receivers that need a payload to outlive the call can return true to keep
+	//the ENet packet it points into, and enet_packet_destroy it themselves later.
+	//Packets made locally, like Player_Connected, have no ENet packet to keep.
+	virtual bool ReceiveOwnedPacket(int type, GamePacket* payload, _ENetPacket* packet, int source) {
+		ReceivePacket(type, payload, source);
+		return false;
+	}
 };
 
 class NetworkBase	{
@@ -69,29 +100,53 @@ public:
 		return 1234;
 	}
 
-	void RegisterPacketHandler(int msgID, PacketReceiver* receiver) {
-		packetHandlers.insert(std::make_pair(msgID, receiver));
+	static const int MaxMessageTypes = 32;
+	static_assert(MessageTypeCount <= MaxMessageTypes, "MaxMessageTypes must cover every BasicNetworkMessages type");
+
+	static int GetChannel(int msgID);
+
+	//Received packets of this type with a payload smaller than minimumSize are dropped
+	//before any handler sees them, so handlers can cast them to fixed size structs
+	void RegisterPacketHandler(int msgID, PacketReceiver* receiver, int minimumSize = 0) {
+		if (msgID < 0 || msgID >= MaxMessageTypes) {
+			return;
+		}
+		packetHandlers[msgID].push_back(receiver);
+		minimumSizes[msgID] = std::max(minimumSizes[msgID], minimumSize);
+	}
+
+	int GetInvalidPacketCount() const {
+		return invalidPackets;
+	}
+
+	//Everything sent and received through this end of the connection
+	NCL::CSC8503::NetworkStats& GetStats() const {
+		return *stats;
 	}
 protected:
 	NetworkBase();
 	~NetworkBase();
 
-	bool ProcessPacket(GamePacket* p, int peerID = -1);
+	bool ProcessPacket(GamePacket* p, int peerID = -1, _ENetPacket* owner = nullptr);
+	//Validates, dispatches, and destroys the packet unless a handler kept it
+	void ProcessPacket(_ENetPacket* packet, int peerID = -1);
 
-	typedef std::multimap<int, PacketReceiver*>::const_iterator PacketHandlerIterator;
+	//An ENet packet with the flags its message type's channel needs
+	static _ENetPacket*	CreatePacket(GamePacket& packet);
+	static int			GetPacketChannel(_ENetPacket* packet);
 
-	bool GetPacketHandlers(int msgID, PacketHandlerIterator& first, PacketHandlerIterator& last) const {
-		auto range = packetHandlers.equal_range(msgID);
-
-		if (range.first == packetHandlers.end()) {
-			return false; //no handlers for this message type!
-		}
-		first	= range.first;
-		last	= range.second;
-		return true;
-	}
+	//The payload in place, or nullptr if the buffer doesn't hold what its header claims
+	GamePacket* GetPacketView(unsigned char* data, size_t length);
 
 	_ENetHost* netHandle;
 
-	std::multimap<int, PacketReceiver*> packetHandlers;
+	//Set instead of netHandle when running over a simulated network
+	NCL::CSC8503::LoopbackNetwork*	loopback;
+	int								loopbackEndpoint;
+
+	std::vector<PacketReceiver*>	packetHandlers[MaxMessageTypes];
+	int								minimumSizes[MaxMessageTypes];
+	int								invalidPackets;
+
+	NCL::CSC8503::NetworkStats*		stats;
 };
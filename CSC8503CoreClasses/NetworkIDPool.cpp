@@ -0,0 +1,33 @@
+#include "NetworkIDPool.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+NetworkIDPool::NetworkIDPool(int reuseDelay) {
+	this->reuseDelay	= reuseDelay;
+	nextID				= 0;
+}
+
+NetworkIDPool::~NetworkIDPool() {
+}
+
+void NetworkIDPool::Clear() {
+	freeIDs.clear();
+	nextID = 0;
+}
+
+int NetworkIDPool::Allocate(int tick) {
+	if (!freeIDs.empty() && tick - freeIDs.front().tick >= reuseDelay) {
+		int id = freeIDs.front().networkID;
+		freeIDs.pop_front();
+		return id;
+	}
+	return nextID++;
+}
+
+void NetworkIDPool::Free(int networkID, int tick) {
+	if (networkID < 0 || networkID >= nextID) {
+		return;
+	}
+	freeIDs.push_back({ networkID, tick });
+}
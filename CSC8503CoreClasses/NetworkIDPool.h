@@ -0,0 +1,48 @@
+#pragma once
+#include "SnapshotScheduler.h"
+#include <deque>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Hands out network IDs, reusing the ones of objects that have gone
+		rather than counting up forever, so that everything indexed by network
+		ID - the scheduler's records for each client, a client's list of
+		objects - stays as small as the number of objects alive at once.
+
+		A freed ID isn't handed out again until reuseDelay ticks have passed,
+		by which time no snapshot that mentions the object that had it can
+		still be waiting on an acknowledgement.
+		*/
+		class NetworkIDPool {
+		public:
+			NetworkIDPool(int reuseDelay = SnapshotScheduler::SentPacketCount);
+			~NetworkIDPool();
+
+			void Clear();
+
+			//Oldest freed ID that's old enough, or a new one. A fresh pool counts up from 0,
+			//so everything built the same way at each end gets the same IDs.
+			int		Allocate(int tick);
+			void	Free(int networkID, int tick);
+
+			int GetAllocatedCount() const {
+				return nextID - (int)freeIDs.size();
+			}
+			//One more than the highest ID ever handed out
+			int GetCapacity() const {
+				return nextID;
+			}
+
+		protected:
+			struct FreeID {
+				int networkID;
+				int tick;	//when it was freed
+			};
+			std::deque<FreeID> freeIDs;	//oldest first
+
+			int nextID;
+			int reuseDelay;
+		};
+	}
+}
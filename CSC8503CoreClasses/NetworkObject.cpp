@@ -1,132 +1,428 @@
 #include "NetworkObject.h"
+#include "SnapshotBuilder.h"
+#include "BitStream.h"
+#include "PhysicsObject.h"
 #include "./enet/enet.h"
 using namespace NCL;
 using namespace CSC8503;
 
+const float viewTickScale = 16.0f; //view ticks are sent in 16ths of a tick
+
+static uint32_t QuantiseMove(float v) {
+	return (uint32_t)(std::round(std::clamp(v, -1.0f, 1.0f) * 127.0f) + 127.0f);
+}
+
+static float DequantiseMove(uint32_t q) {
+	return ((int)q - 127) / 127.0f;
+}
+
+static uint32_t QuantiseAngle(float degrees) {
+	float wrapped = degrees - 360.0f * std::floor(degrees / 360.0f);
+	return (uint32_t)std::round(wrapped * 65536.0f / 360.0f) & 0xFFFF;
+}
+
+static float DequantiseAngle(uint32_t q) {
+	return q * 360.0f / 65536.0f;
+}
+
+static uint32_t QuantiseViewTick(float tick) {
+	return (uint32_t)std::round(std::max(0.0f, tick + 1.0f) * viewTickScale);
+}
+
+static float DequantiseViewTick(uint32_t q) {
+	return q / viewTickScale - 1.0f;
+}
+
+void PlayerInput::Quantise() {
+	moveX		= DequantiseMove(QuantiseMove(moveX));
+	moveZ		= DequantiseMove(QuantiseMove(moveZ));
+	aimPitch	= DequantiseAngle(QuantiseAngle(aimPitch));
+	aimYaw		= DequantiseAngle(QuantiseAngle(aimYaw));
+	viewTick	= DequantiseViewTick(QuantiseViewTick(viewTick));
+	buttons		&= 7;
+}
+
+/*
+Older inputs mostly hold the same keys and aim as the one after them, so
+each one costs a couple of flag bits, the buttons, and how far its view
+tick is from being exactly one tick behind.
+*/
+void ClientPacket::WriteInputs(const PlayerInput* inputs, int count) {
+	count = std::min(count, MaxInputs);
+	for (int i = 1; i < count; ++i) {
+		if (inputs[i].sequence != inputs[i - 1].sequence - 1) {
+			count = i;
+			break;
+		}
+	}
+	BitWriter stream(inputData, sizeof(inputData));
+	stream.WriteBits(count, 4);
+
+	for (int i = 0; i < count; ++i) {
+		const PlayerInput& input = inputs[i];
+		if (i == 0) {
+			stream.WriteVarUInt(input.sequence);
+			stream.WriteVarUInt(QuantiseViewTick(input.viewTick));
+		}
+		else {
+			const PlayerInput& next = inputs[i - 1];
+			int expected = (int)QuantiseViewTick(next.viewTick) - (int)viewTickScale;
+			stream.WriteVarInt((int)QuantiseViewTick(input.viewTick) - expected);
+		}
+		bool sameMove	= i > 0 && QuantiseMove(input.moveX) == QuantiseMove(inputs[i - 1].moveX) && QuantiseMove(input.moveZ) == QuantiseMove(inputs[i - 1].moveZ);
+		bool sameAim	= i > 0 && QuantiseAngle(input.aimPitch) == QuantiseAngle(inputs[i - 1].aimPitch) && QuantiseAngle(input.aimYaw) == QuantiseAngle(inputs[i - 1].aimYaw);
+		if (i > 0) {
+			stream.WriteBool(sameMove);
+			stream.WriteBool(sameAim);
+		}
+		if (!sameMove) {
+			stream.WriteBits(QuantiseMove(input.moveX), 8);
+			stream.WriteBits(QuantiseMove(input.moveZ), 8);
+		}
+		if (!sameAim) {
+			stream.WriteBits(QuantiseAngle(input.aimPitch), 16);
+			stream.WriteBits(QuantiseAngle(input.aimYaw), 16);
+		}
+		stream.WriteBits(input.buttons & 7, 3);
+	}
+	stream.Flush();
+	size = MinimumSize + stream.GetBytesWritten();
+}
+
+int ClientPacket::ReadInputs(PlayerInput* inputs, int maxCount) const {
+	BitReader stream(inputData, std::clamp(size - MinimumSize, 0, (int)sizeof(inputData)));
+	int count = std::min((int)stream.ReadBits(4), std::min(maxCount, MaxInputs));
+
+	uint32_t viewTick = 0;
+	for (int i = 0; i < count; ++i) {
+		PlayerInput& input = inputs[i];
+		bool sameMove	= false;
+		bool sameAim	= false;
+		if (i == 0) {
+			input.sequence	= stream.ReadVarNonNegative();
+			viewTick		= stream.ReadVarUInt();
+		}
+		else {
+			input			= inputs[i - 1];
+			input.sequence	= inputs[i - 1].sequence - 1;
+			viewTick		= viewTick - (uint32_t)viewTickScale + stream.ReadVarInt();
+			sameMove		= stream.ReadBool();
+			sameAim			= stream.ReadBool();
+		}
+		input.viewTick = DequantiseViewTick(viewTick);
+		if (!sameMove) {
+			input.moveX = DequantiseMove(stream.ReadBits(8));
+			input.moveZ = DequantiseMove(stream.ReadBits(8));
+		}
+		if (!sameAim) {
+			input.aimPitch	= DequantiseAngle(stream.ReadBits(16));
+			input.aimYaw	= DequantiseAngle(stream.ReadBits(16));
+		}
+		input.buttons = (uint8_t)stream.ReadBits(3);
+	}
+	return stream.HasOverflowed() ? 0 : count;
+}
+
 NetworkObject::NetworkObject(GameObject& o, int id) : object(o)	{
 	deltaErrors = 0;
 	fullErrors  = 0;
 	networkID   = id;
+	spawnStateID = -1;
+	lastFullState.stateID = -1;
+	lastChangeID = INT_MAX; //always send until the first change check has run
+	tickState.stateID = -1;
+	tickSpeed = 0.0f;
+	interpolationSamples.reserve(MaxInterpolationSamples);
+
+	stateHistory.resize(StateHistorySize);
+	for (NetworkState& s : stateHistory) {
+		s.stateID = -1;
+	}
+	oldestStateID = 0;
 }
 
 NetworkObject::~NetworkObject()	{
 }
 
-bool NetworkObject::ReadPacket(GamePacket& p) 
+bool NetworkObject::ReadPacket(const SnapshotHeader& header, const SnapshotEntry& entry, const StateQuantisation& q) 
 {
-	if (p.type == Delta_State) return ReadDeltaPacket((DeltaPacket&)p);
-	if (p.type == Full_State) return ReadFullPacket((FullPacket&)p);
-
-	return false; 
+	if (header.stateID < spawnStateID) {
+		return false; //a late snapshot, from before this object was spawned
+	}
+	if (entry.fullState) return ReadFullPacket(entry, header.stateID, q);
+	return ReadDeltaPacket(entry, header.stateID, q);
 }
 
-bool NetworkObject::WritePacket(GamePacket** p, bool deltaFrame, int stateID) {
+bool NetworkObject::WritePacket(SnapshotBuilder& builder, bool deltaFrame, int stateID) {
 	if (deltaFrame) {
-		if (!WriteDeltaPacket(p, stateID)) {
-			return WriteFullPacket(p);
+		if (WriteDeltaPacket(builder, stateID)) {
+			return true;
 		}
+		//The client hasn't acknowledged a state we still have, so send it
+		//our newest full state again to give it something to acknowledge
+		deltaErrors++;
 	}
-	return WriteFullPacket(p);
+	return WriteFullPacket(builder);
 }
-//Client objects recieve these packets
-bool NetworkObject::ReadDeltaPacket(DeltaPacket &p) 
-{
-	if (p.fullID != lastFullState.stateID) return false;
-	UpdateStateHistory(p.fullID);
 
-	Vector3 fullPos = lastFullState.position;
-	Quaternion fullOrientation = lastFullState.orientation;
+void NetworkObject::UpdateLastChange(int stateID, const StateQuantisation& q) {
+	tickState.position		= object.GetTransform().GetPosition();
+	tickState.orientation	= object.GetTransform().GetOrientation();
+	tickState.quantised		= q.Quantise(tickState.position, tickState.orientation);
+	tickState.stateID		= stateID;
+	tickSpeed = object.GetPhysicsObject() ? object.GetPhysicsObject()->GetLinearVelocity().Length() : 0.0f;
+
+	if (!(tickState.quantised == lastQuantisedState)) {
+		lastQuantisedState	= tickState.quantised;
+		lastChangeID		= stateID;
+	}
+}
 
-	fullPos.x += p.pos[0];
-	fullPos.y += p.pos[1];
-	fullPos.z += p.pos[2];
+/*
+Received states aren't put on screen straight away, they go into a buffer
+that UpdateInterpolation plays back a little behind the server. Datagrams
+can arrive out of order, so samples are kept sorted by state ID.
+*/
+void NetworkObject::ApplyState(const QuantisedState& state, int stateID, const StateQuantisation& q) {
+	auto i = std::lower_bound(interpolationSamples.begin(), interpolationSamples.end(), stateID,
+		[](const InterpolationSample& s, int id) { return s.stateID < id; });
 
-	fullOrientation.x += ((float)p.orientation[0]) / 127.0f;
-	fullOrientation.y += ((float)p.orientation[1]) / 127.0f;
-	fullOrientation.z += ((float)p.orientation[2]) / 127.0f;
-	fullOrientation.w += ((float)p.orientation[3]) / 127.0f;
+	if (i != interpolationSamples.end() && i->stateID == stateID) {
+		return;
+	}
+	if (i == interpolationSamples.begin() && interpolationSamples.size() >= MaxInterpolationSamples) {
+		return; //older than anything we're keeping
+	}
+	interpolationSamples.insert(i, { stateID, q.DequantisePosition(state), q.DequantiseOrientation(state) });
+	if (interpolationSamples.size() > MaxInterpolationSamples) {
+		interpolationSamples.erase(interpolationSamples.begin());
+	}
+}
 
-	object.GetTransform().SetPosition(fullPos);
-	object.GetTransform().SetOrientation(fullOrientation);
+static Quaternion InterpolateOrientation(const Quaternion& from, Quaternion to, float t) {
+	//Take the short way round
+	if (Quaternion::Dot(from, to) < 0.0f) {
+		to = to * -1.0f;
+	}
+	return Quaternion::Slerp(from, to, t);
+}
 
-	return true;
+void NetworkObject::UpdateInterpolation(float renderTick, float maxExtrapolation) {
+	if (interpolationSamples.empty()) {
+		return;
+	}
+	Transform& transform = object.GetTransform();
+
+	const InterpolationSample& first = interpolationSamples.front();
+	const InterpolationSample& last	 = interpolationSamples.back();
+
+	if (renderTick <= first.stateID) {
+		transform.SetPosition(first.position);
+		transform.SetOrientation(first.orientation);
+		return;
+	}
+	if (renderTick >= last.stateID) {
+		//Only carry on moving if the last two states were sent close together - otherwise
+		//we don't know how the object was moving, just where it ended up
+		size_t count = interpolationSamples.size();
+		if (count < 2 || last.stateID - interpolationSamples[count - 2].stateID > 1) {
+			transform.SetPosition(last.position);
+			transform.SetOrientation(last.orientation);
+			return;
+		}
+		const InterpolationSample& previous = interpolationSamples[count - 2];
+		float t = 1.0f + std::min(renderTick - last.stateID, maxExtrapolation);
+		transform.SetPosition(previous.position + (last.position - previous.position) * t);
+		transform.SetOrientation(last.orientation);
+		return;
+	}
+	auto next = std::upper_bound(interpolationSamples.begin(), interpolationSamples.end(), renderTick,
+		[](float tick, const InterpolationSample& s) { return tick < s.stateID; });
+	const InterpolationSample& b = *next;
+	const InterpolationSample& a = *(next - 1);
+
+	//Unchanged objects aren't sent, so a long gap means it sat still and then moved
+	float start = (float)std::max(a.stateID, b.stateID - MaxInterpolationGap);
+	float t		= std::clamp((renderTick - start) / (b.stateID - start), 0.0f, 1.0f);
+
+	transform.SetPosition(a.position + (b.position - a.position) * t);
+	transform.SetOrientation(InterpolateOrientation(a.orientation, b.orientation, t));
 }
 
-bool NetworkObject::ReadFullPacket(FullPacket &p) 
+//Client objects recieve these packets
+bool NetworkObject::ReadDeltaPacket(const SnapshotEntry& entry, int stateID, const StateQuantisation& q) 
 {
-	if (p.fullState.stateID < lastFullState.stateID) return false;
-	lastFullState = p.fullState;
+	//The server builds deltas against the newest full state it knows we have,
+	//which may be older than the newest full state we've received since
+	int baselineID = stateID - entry.baselineOffset;
+	NetworkState baseState;
+	if (!GetNetworkState(baselineID, baseState)) {
+		deltaErrors++;
+		return false;
+	}
+	UpdateStateHistory(baselineID);
+
+	QuantisedState state = baseState.quantised;
+	if (entry.hasPosition) {
+		for (int i = 0; i < 3; ++i) {
+			state.position[i] = entry.smallPosition ? state.position[i] + entry.positionDelta[i] : entry.state.position[i];
+		}
+	}
+	if (entry.hasOrientation) {
+		state.orientation = entry.state.orientation;
+	}
+	ApplyState(state, stateID, q);
 
-	object.GetTransform().SetPosition(lastFullState.position);
-	object.GetTransform().SetOrientation(lastFullState.orientation);
+	return true;
+}
 
-	stateHistory.emplace_back(lastFullState);
+bool NetworkObject::ReadFullPacket(const SnapshotEntry& entry, int stateID, const StateQuantisation& q) 
+{
+	if (HasNetworkState(stateID)) {
+		return true; //a resend of a state we already have
+	}
+	//Even if it's arrived out of order, the server might use it as a baseline once we've acknowledged it
+	NetworkState state;
+	state.quantised		= entry.state;
+	state.position		= q.DequantisePosition(entry.state);
+	state.orientation	= q.DequantiseOrientation(entry.state);
+	state.stateID		= stateID;
+	AddNetworkState(state);
+
+	if (stateID > lastFullState.stateID) {
+		lastFullState = state;
+	}
+	else {
+		fullErrors++;
+	}
+	ApplyState(entry.state, stateID, q);
 
 	return true;
 }
 
-bool NetworkObject::WriteDeltaPacket(GamePacket**p, int stateID) 
+bool NetworkObject::WriteDeltaPacket(SnapshotBuilder& builder, int stateID) 
 {
-	DeltaPacket* dp = new DeltaPacket();
 	NetworkState state;
 	if (!GetNetworkState(stateID, state)) return false;
 
-	dp->fullID = stateID;
-	dp->objectID = networkID;
+	if (lastChangeID <= stateID) {
+		return true; //hasn't moved since the baseline, so there's nothing to send
+	}
+	const StateQuantisation& q = builder.GetQuantisation();
 
-	Vector3 currentPos = object.GetTransform().GetPosition();
-	Quaternion currentOrientation = object.GetTransform().GetOrientation();
+	SnapshotEntry entry;
+	entry.objectID			= networkID;
+	entry.baselineOffset	= builder.GetHeader().stateID - stateID;
+	entry.state				= lastQuantisedState;
 
-	currentPos -= state.position;
-	currentOrientation -= state.orientation;
+	//An entry with nothing in it still tells the client to go back to the baseline
+	for (int i = 0; i < 3; ++i) {
+		int delta = (int)entry.state.position[i] - (int)state.quantised.position[i];
+		entry.positionDelta[i] = delta;
+		entry.hasPosition |= (delta != 0);
+	}
+	int smallLimit		= 1 << (q.smallDeltaBits - 1);
+	entry.smallPosition = true;
+	for (int i = 0; i < 3; ++i) {
+		if (entry.positionDelta[i] < -smallLimit || entry.positionDelta[i] >= smallLimit) {
+			entry.smallPosition = false;
+		}
+	}
+	entry.hasOrientation = entry.state.orientation != state.quantised.orientation;
 
-	dp->pos[0] = (char)currentPos.x;
-	dp->pos[1] = (char)currentPos.y;
-	dp->pos[2] = (char)currentPos.z;
-	
-	dp->orientation[0] = (char)(currentOrientation.x * 127.0f);
-	dp->orientation[1] = (char)(currentOrientation.y * 127.0f);
-	dp->orientation[2] = (char)(currentOrientation.z * 127.0f);
-	dp->orientation[3] = (char)(currentOrientation.w * 127.0f);
-	*p = dp;
+	builder.AddEntry(entry);
 	return true;
 }
 
-bool NetworkObject::WriteFullPacket(GamePacket**p) 
+void NetworkObject::StoreFullState(int stateID) 
 {
-	FullPacket* fp = new FullPacket();
+	//Not the transform - the server may be writing packets while the next tick is simulated
+	lastFullState			= tickState;
+	lastFullState.stateID	= stateID;
+	//Kept so that later deltas can be built against it, once a client acknowledges it
+	AddNetworkState(lastFullState);
+}
+
+bool NetworkObject::WriteFullPacket(SnapshotBuilder& builder) 
+{
+	int stateID = builder.GetHeader().stateID;
+	if (lastFullState.stateID != stateID) {
+		StoreFullState(stateID);
+	}
+	SnapshotEntry entry;
+	entry.objectID	= networkID;
+	entry.fullState = true;
+	entry.state		= lastFullState.quantised;
 
-	fp->objectID = networkID;
-	fp->fullState.position = object.GetTransform().GetPosition();
-	fp->fullState.orientation = object.GetTransform().GetOrientation();
-	fp->fullState.stateID = lastFullState.stateID++;
-	*p = fp;
+	builder.AddEntry(entry);
 	return true;
 }
 
+/*
+Spawn packets are reliable, so the server can build deltas against the
+state it sends with one as soon as it's sent - the snapshots after it may
+arrive first, but they'll just be ignored until the object exists.
+*/
+const QuantisedState& NetworkObject::WriteBaseline(int stateID)
+{
+	if (lastFullState.stateID != stateID) {
+		StoreFullState(stateID);
+	}
+	return lastFullState.quantised;
+}
+
+void NetworkObject::ReadBaseline(const QuantisedState& state, int stateID, const StateQuantisation& q)
+{
+	spawnStateID = stateID;
+	UpdateStateHistory(stateID);
+
+	SnapshotEntry entry;
+	entry.objectID	= networkID;
+	entry.fullState = true;
+	entry.state		= state;
+	ReadFullPacket(entry, stateID, q);
+}
+
+bool NetworkObject::HasNetworkState(int stateID) const 
+{
+	if (stateID < oldestStateID) {
+		return false;
+	}
+	return stateHistory[stateID % StateHistorySize].stateID == stateID;
+}
+
 NetworkState& NetworkObject::GetLatestNetworkState() 
 {
 	return lastFullState;
 }
 
-bool NetworkObject::GetNetworkState(int stateID, NetworkState& state) 
+bool NetworkObject::GetNetworkState(int stateID, NetworkState& state) const
 {
-	for (auto i = stateHistory.begin(); i < stateHistory.end(); i++)
-	{
-		if ((*i).stateID == stateID)
-		{
-			state = (*i);
-			return true;
-		}
+	if (!HasNetworkState(stateID)) {
+		return false;
+	}
+	state = stateHistory[stateID % StateHistorySize];
+	return true;
+}
+
+/*
+Each state goes in the slot its ID maps to, replacing whatever was
+StateHistorySize ticks older, so nothing is ever allocated or shuffled.
+*/
+void NetworkObject::AddNetworkState(const NetworkState& state) 
+{
+	if (state.stateID < oldestStateID) {
+		return;
+	}
+	NetworkState& slot = stateHistory[state.stateID % StateHistorySize];
+	if (slot.stateID > state.stateID) {
+		return; //a late arrival, whose slot has already been reused
 	}
-	return false;
+	slot = state;
 }
 
+//Trimming just moves the cutoff - the old slots are reused as new states come in
 void NetworkObject::UpdateStateHistory(int minID) 
 {
-	for (auto i = stateHistory.begin(); i < stateHistory.end();)
-	{
-		if ((*i).stateID < minID) i = stateHistory.erase(i);
-		else i++;
-	}
+	oldestStateID = std::max(oldestStateID, minID);
 }
\ No newline at end of file
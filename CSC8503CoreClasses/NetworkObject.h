@@ -5,35 +5,72 @@
 
 namespace NCL::CSC8503 {
 	class GameObject;
+	class SnapshotBuilder;
+	struct SnapshotHeader;
+	struct SnapshotEntry;
+
+	//One tick's worth of a client's controls. The server and the client's own
+	//prediction both feed these through NetworkedGame::ApplyPlayerInput.
+	struct PlayerInput {
+		enum Buttons : uint8_t {
+			Jump	= 1,
+			Dash	= 2,
+			Grapple	= 4	//held, rather than pressed
+		};
+		int		sequence	= -1;
+		float	moveX		= 0.0f;	//camera relative WASD direction, flat on the ground
+		float	moveZ		= 0.0f;
+		float	aimPitch	= 0.0f;	//camera angles, which way a dash goes
+		float	aimYaw		= 0.0f;
+		float	viewTick	= -1.0f;	//server tick the client was drawing other objects at
+		uint8_t	buttons		= 0;
+
+		//Rounds everything to what a ClientPacket can carry, so that the
+		//client predicts with exactly the input the server will get
+		void Quantise();
+	};
 
-	struct FullPacket : public GamePacket {
-		int		objectID = -1;
-		NetworkState fullState;
+	/*
+	Sent by clients every tick - lastID is the newest snapshot datagram they've
+	received, and bit n of ackBits is set if datagram lastID - 1 - n arrived too.
 
-		FullPacket() {
-			type = Full_State;
-			size = sizeof(FullPacket) - sizeof(GamePacket);
-		}
-	};
+	Rather than being sent reliably, each input is sent again in the next few
+	packets, so the server can fill in any it missed from the next packet
+	that does arrive. The newest input is written in full, and each one
+	before it only as what's different from the input after it, bit packed.
+	*/
+	struct ClientPacket : public GamePacket {
+		static const int MaxInputs		= 8;
+		static const int MinimumSize	= sizeof(int) + sizeof(uint32_t);
 
-	struct DeltaPacket : public GamePacket {
-		int		fullID		= -1;
-		int		objectID	= -1;
-		char	pos[3];
-		char	orientation[4];
+		int			lastID			= -1;
+		uint32_t	ackBits			= 0;
+		char		inputData[128];
 
-		DeltaPacket() {
-			type = Delta_State;
-			size = sizeof(DeltaPacket) - sizeof(GamePacket);
+		ClientPacket() {
+			type = Received_State;
+			size = MinimumSize;
 		}
-	};
 
-	struct ClientPacket : public GamePacket {
-		int		lastID;
-		char	buttonstates[8];
+		//Newest first, and with consecutive sequence numbers - it stops at the first gap
+		void WriteInputs(const PlayerInput* inputs, int count);
+		//Newest first, returns how many were read
+		int ReadInputs(PlayerInput* inputs, int maxCount) const;
+	};
 
-		ClientPacket() {
-			size = sizeof(ClientPacket);
+	//Sent by the server to each client every tick, so it can check its
+	//predicted player against where the server actually put it
+	struct PlayerStatePacket : public GamePacket {
+		int			networkID	= -1;
+		int			lastInput	= -1;	//newest input sequence the server has applied
+		Vector3		position;
+		Quaternion	orientation;
+		Vector3		linearVelocity;
+		Vector3		angularVelocity;
+
+		PlayerStatePacket() {
+			type = Player_State;
+			size = sizeof(PlayerStatePacket) - sizeof(GamePacket);
 		}
 	};
 
@@ -43,33 +80,90 @@ namespace NCL::CSC8503 {
 		virtual ~NetworkObject();
 
 		//Called by clients
-		virtual bool ReadPacket(GamePacket& p);
-		//Called by servers
-		virtual bool WritePacket(GamePacket** p, bool deltaFrame, int stateID);
+		virtual bool ReadPacket(const SnapshotHeader& header, const SnapshotEntry& entry, const StateQuantisation& q);
+		//Called by servers - delta packets are relative to stateID, a state the client is
+		//known to have. Full packets store the current state under the snapshot's state ID.
+		virtual bool WritePacket(SnapshotBuilder& builder, bool deltaFrame, int stateID);
+
+		//Called by servers once per tick, before any packets are written. The object's
+		//state is copied, so packets can be written while the world carries on.
+		void UpdateLastChange(int stateID, const StateQuantisation& q);
+		const NetworkState& GetTickState() const {
+			return tickState;
+		}
+		float GetTickSpeed() const {
+			return tickSpeed;
+		}
+
+		bool HasChangedSince(int stateID) const {
+			return lastChangeID > stateID;
+		}
+		bool HasNetworkState(int stateID) const;
+
+		//Spawned objects start from the state sent along with the spawn, rather than a snapshot.
+		//The server stores its state under stateID (it must be this tick's) and returns it...
+		const QuantisedState& WriteBaseline(int stateID);
+		//...and the client takes it as a full state, ignoring anything older from then on
+		void ReadBaseline(const QuantisedState& state, int stateID, const StateQuantisation& q);
+
+		//Called by clients every frame. renderTick is a (fractional) server tick a little
+		//behind the newest one received, so there's usually a state either side of it.
+		//Past the newest state, the object carries on moving for up to maxExtrapolation ticks.
+		void UpdateInterpolation(float renderTick, float maxExtrapolation);
 
 		void UpdateStateHistory(int minID);
 
+		int GetNetworkID() const {
+			return networkID;
+		}
+
+		GameObject& GetGameObject() const {
+			return object;
+		}
+
 	protected:
 
 		NetworkState& GetLatestNetworkState();
 
-		bool GetNetworkState(int frameID, NetworkState& state);
+		bool GetNetworkState(int frameID, NetworkState& state) const;
+		void AddNetworkState(const NetworkState& state);
+
+		virtual bool ReadDeltaPacket(const SnapshotEntry& entry, int stateID, const StateQuantisation& q);
+		virtual bool ReadFullPacket(const SnapshotEntry& entry, int stateID, const StateQuantisation& q);
+
+		virtual bool WriteDeltaPacket(SnapshotBuilder& builder, int stateID);
+		virtual bool WriteFullPacket(SnapshotBuilder& builder);
 
-		virtual bool ReadDeltaPacket(DeltaPacket &p);
-		virtual bool ReadFullPacket(FullPacket &p);
+		void StoreFullState(int stateID);
+		void ApplyState(const QuantisedState& state, int stateID, const StateQuantisation& q);
 
-		virtual bool WriteDeltaPacket(GamePacket**p, int stateID);
-		virtual bool WriteFullPacket(GamePacket**p);
+		struct InterpolationSample {
+			int			stateID;
+			Vector3		position;
+			Quaternion	orientation;
+		};
+		static const int StateHistorySize			= 64; //ticks - older baselines fall back to full states
+		static const int MaxInterpolationSamples	= 16;
+		static const int MaxInterpolationGap		= 4; //ticks - longer gaps are objects that sat still, then moved
 
 		GameObject& object;
 
 		NetworkState lastFullState;
 
-		std::vector<NetworkState> stateHistory;
+		std::vector<NetworkState>	stateHistory;	//ring, indexed by state ID
+		int							oldestStateID;	//anything before this has been trimmed
+
+		QuantisedState	lastQuantisedState;
+		int				lastChangeID;
+
+		NetworkState	tickState;	//as it was when UpdateLastChange was last called
+		float			tickSpeed;
+		std::vector<InterpolationSample> interpolationSamples; //client: received states, in state ID order
 
 		int deltaErrors;
 		int fullErrors;
 
 		int networkID;
+		int spawnStateID;	//client: states older than this were about whatever had the network ID before
 	};
-}
\ No newline at end of file
+}
@@ -8,4 +8,75 @@ NetworkState::NetworkState()	{
 }
 
 NetworkState::~NetworkState()	{
-}
\ No newline at end of file
+}
+
+static uint32_t QuantiseFloat(float value, float min, float max, int bits) {
+	uint32_t maxValue = (1u << bits) - 1;
+	float t = std::clamp((value - min) / (max - min), 0.0f, 1.0f);
+	return (uint32_t)(t * maxValue + 0.5f);
+}
+
+static float DequantiseFloat(uint32_t value, float min, float max, int bits) {
+	uint32_t maxValue = (1u << bits) - 1;
+	return min + (max - min) * ((float)value / maxValue);
+}
+
+const float smallestThreeRange = 0.70710678f; //1 / sqrt(2)
+
+QuantisedState StateQuantisation::Quantise(const Vector3& position, const Quaternion& orientation) const {
+	QuantisedState s;
+	for (int i = 0; i < 3; ++i) {
+		s.position[i] = QuantiseFloat(position[i], boundsMin[i], boundsMax[i], positionBits);
+	}
+
+	float q[4] = { orientation.x, orientation.y, orientation.z, orientation.w };
+	int largest = 0;
+	for (int i = 1; i < 4; ++i) {
+		if (std::abs(q[i]) > std::abs(q[largest])) {
+			largest = i;
+		}
+	}
+	//q and -q are the same rotation, so flip it to make the dropped component positive
+	float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+	s.orientation = largest;
+	int shift = 2;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			continue;
+		}
+		s.orientation |= QuantiseFloat(q[i] * sign, -smallestThreeRange, smallestThreeRange, orientationBits) << shift;
+		shift += orientationBits;
+	}
+	return s;
+}
+
+Vector3 StateQuantisation::DequantisePosition(const QuantisedState& state) const {
+	Vector3 p;
+	for (int i = 0; i < 3; ++i) {
+		p[i] = DequantiseFloat(state.position[i], boundsMin[i], boundsMax[i], positionBits);
+	}
+	return p;
+}
+
+Quaternion StateQuantisation::DequantiseOrientation(const QuantisedState& state) const {
+	uint32_t mask	= (1u << orientationBits) - 1;
+	int largest		= state.orientation & 3;
+	int shift		= 2;
+
+	float q[4];
+	float sum = 0.0f;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			continue;
+		}
+		q[i] = DequantiseFloat((state.orientation >> shift) & mask, -smallestThreeRange, smallestThreeRange, orientationBits);
+		sum += q[i] * q[i];
+		shift += orientationBits;
+	}
+	q[largest] = sqrt(std::max(0.0f, 1.0f - sum));
+
+	Quaternion result(q[0], q[1], q[2], q[3]);
+	result.Normalise();
+	return result;
+}
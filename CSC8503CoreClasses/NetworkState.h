@@ -3,6 +3,38 @@
 namespace NCL {
 	using namespace Maths;
 	namespace CSC8503 {
+		//A state as it goes over the wire - identical quantised states can be skipped
+		struct QuantisedState {
+			uint32_t position[3]	= { 0, 0, 0 };
+			uint32_t orientation	= 0;
+
+			bool operator==(const QuantisedState& other) const {
+				return	position[0] == other.position[0] &&
+						position[1] == other.position[1] &&
+						position[2] == other.position[2] &&
+						orientation == other.orientation;
+			}
+		};
+
+		/*
+		Positions are stored as fixed point values across the level bounds,
+		and orientations with 'smallest three' compression - the largest
+		component is dropped (its index takes 2 bits) and rebuilt from the
+		other three, which can then only be in the range +/- 1/sqrt(2).
+		*/
+		struct StateQuantisation {
+			Vector3 boundsMin		= Vector3(-512.0f, -64.0f, -512.0f);
+			Vector3 boundsMax		= Vector3( 512.0f, 192.0f,  512.0f);
+			int		positionBits	= 18;
+			int		orientationBits	= 10; //per component, so 2 + 3 * 10 bits in total
+			int		smallDeltaBits	= 8;  //position changes that fit in this are sent relative to the baseline
+
+			QuantisedState	Quantise(const Vector3& position, const Quaternion& orientation) const;
+
+			Vector3			DequantisePosition(const QuantisedState& state) const;
+			Quaternion		DequantiseOrientation(const QuantisedState& state) const;
+		};
+
 		//class GameObject;
 		class NetworkState	{
 		public:
@@ -12,7 +44,8 @@ namespace NCL {
 			Vector3		position;
 			Quaternion	orientation;
 			int			stateID;
+
+			QuantisedState quantised; //what was actually sent for this state
 		};
 	}
 }
-
@@ -0,0 +1,108 @@
+#include "NetworkStats.h"
+#include "Debug.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+NetworkStats::NetworkStats() {
+	unhandledPackets	= 0;
+	roundTripTime		= 0.0f;
+	packetLoss			= 0.0f;
+	fullEntries			= 0;
+	deltaEntries		= 0;
+	rateTimer			= 0.0f;
+}
+
+NetworkStats::~NetworkStats() {
+}
+
+const char* NetworkStats::GetMessageName(int type) {
+	static const char* names[] = {
+		"None", "Hello", "Message", "String_Message", "Delta_State", "Full_State", "Received_State",
+		"Player_Connected", "Player_Disconnected", "Shutdown", "Snapshot_State", "Player_State",
+		"Spawn_State"
+	};
+	if (type >= 0 && type < (int)(sizeof(names) / sizeof(names[0]))) {
+		return names[type];
+	}
+	return "Unknown";
+}
+
+void NetworkStats::RecordPacket(Direction d, int type, int bytes) {
+	if (type < 0 || type >= NetworkBase::MaxMessageTypes) {
+		return;
+	}
+	counters[d][type].packets++;
+	counters[d][type].bytes += bytes;
+}
+
+NetworkStats::Counter NetworkStats::GetTotal(Direction d) const {
+	Counter total;
+	for (const Counter& c : counters[d]) {
+		total.packets	+= c.packets;
+		total.bytes		+= c.bytes;
+	}
+	return total;
+}
+
+float NetworkStats::GetDeltaRatio() const {
+	int total = fullEntries + deltaEntries;
+	return total > 0 ? (float)deltaEntries / total : 0.0f;
+}
+
+void NetworkStats::Update(float dt) {
+	rateTimer += dt;
+	if (rateTimer < 1.0f) {
+		return;
+	}
+	for (int d = 0; d < DirectionCount; ++d) {
+		for (int t = 0; t < NetworkBase::MaxMessageTypes; ++t) {
+			rates[d][t].packets	= (int)((counters[d][t].packets - lastCounters[d][t].packets) / rateTimer);
+			rates[d][t].bytes	= (int64_t)((counters[d][t].bytes - lastCounters[d][t].bytes) / rateTimer);
+			lastCounters[d][t]	= counters[d][t];
+		}
+	}
+	rateTimer = 0.0f;
+}
+
+/*
+One line for the connection as a whole, then one for each message type
+that's had any traffic in the last second.
+*/
+void NetworkStats::Print(const Vector2& position, float lineSpacing) const {
+	Vector2 linePosition = position;
+	Debug::Print("RTT " + std::to_string((int)roundTripTime) + "ms, loss " + std::to_string((int)(packetLoss * 100.0f))
+		+ "%, deltas " + std::to_string((int)(GetDeltaRatio() * 100.0f)) + "%", linePosition);
+
+	for (int t = 0; t < NetworkBase::MaxMessageTypes; ++t) {
+		const Counter& out	= rates[Sent][t];
+		const Counter& in	= rates[Received][t];
+		if (out.packets == 0 && in.packets == 0) {
+			continue;
+		}
+		linePosition.y += lineSpacing;
+		Debug::Print(std::string(GetMessageName(t))
+			+ ": out " + std::to_string(out.packets) + "/s " + std::to_string(out.bytes) + "B/s"
+			+ ", in " + std::to_string(in.packets) + "/s " + std::to_string(in.bytes) + "B/s", linePosition);
+	}
+}
+
+void NetworkStats::WriteCSVHeader(std::ostream& out) const {
+	out << "time,rtt_ms,loss,full_entries,delta_entries,unhandled";
+	for (int t = 0; t < MessageTypeCount; ++t) {
+		const char* name = GetMessageName(t);
+		out << "," << name << "_sent_packets," << name << "_sent_bytes,"
+			<< name << "_received_packets," << name << "_received_bytes";
+	}
+	out << "\n";
+}
+
+void NetworkStats::WriteCSVRow(std::ostream& out, float time) const {
+	out << time << "," << roundTripTime << "," << packetLoss << ","
+		<< fullEntries << "," << deltaEntries << "," << unhandledPackets;
+	for (int t = 0; t < MessageTypeCount; ++t) {
+		out << "," << counters[Sent][t].packets << "," << counters[Sent][t].bytes
+			<< "," << counters[Received][t].packets << "," << counters[Received][t].bytes;
+	}
+	out << "\n";
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "NetworkBase.h"
+#include "Vector2.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Counts every packet a server or client sends and receives, by message
+		type, along with the connection's round trip time and loss, and how
+		many snapshot entries were deltas rather than full states. Once a
+		second, Update works out the rates that Print shows on screen. For
+		looking at later, WriteCSVRow appends the running totals as one line
+		of a CSV file.
+		*/
+		class NetworkStats {
+		public:
+			enum Direction {
+				Sent,
+				Received,
+				DirectionCount
+			};
+
+			struct Counter {
+				int			packets = 0;
+				int64_t		bytes	= 0;
+			};
+
+			NetworkStats();
+			~NetworkStats();
+
+			void RecordPacket(Direction d, int type, int bytes);
+			void RecordUnhandled() {
+				unhandledPackets++;
+			}
+			//Can be called from any thread - rooms on a server write their snapshots in parallel
+			void RecordSnapshotEntries(int full, int delta) {
+				fullEntries		+= full;
+				deltaEntries	+= delta;
+			}
+
+			void SetRoundTripTime(float milliseconds) {
+				roundTripTime = milliseconds;
+			}
+			void SetPacketLoss(float fraction) {
+				packetLoss = fraction;
+			}
+
+			const Counter& GetCounter(Direction d, int type) const {
+				return counters[d][type];
+			}
+			Counter GetTotal(Direction d) const;
+
+			float GetRoundTripTime() const {
+				return roundTripTime;
+			}
+			float GetPacketLoss() const {
+				return packetLoss;
+			}
+			//Of all the snapshot entries so far, the fraction that were deltas
+			float GetDeltaRatio() const;
+
+			void Update(float dt);
+			void Print(const Vector2& position, float lineSpacing = 4.0f) const;
+
+			void WriteCSVHeader(std::ostream& out) const;
+			void WriteCSVRow(std::ostream& out, float time) const;
+
+			static const char* GetMessageName(int type);
+
+		protected:
+			Counter	counters[DirectionCount][NetworkBase::MaxMessageTypes];
+			Counter	lastCounters[DirectionCount][NetworkBase::MaxMessageTypes];	//as they were at the last rate update
+			Counter	rates[DirectionCount][NetworkBase::MaxMessageTypes];		//per second
+
+			int		unhandledPackets;
+			float	roundTripTime;	//milliseconds
+			float	packetLoss;
+
+			std::atomic<int>	fullEntries;
+			std::atomic<int>	deltaEntries;
+
+			float	rateTimer;
+		};
+	}
+}
@@ -0,0 +1,37 @@
+#include "PhysicsSnapshot.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+static_assert(std::is_trivially_copyable_v<BodyState>, "BodyState must be memcpy-able");
+static_assert(std::is_trivially_copyable_v<CollisionDetection::CollisionInfo>, "CollisionInfo must be memcpy-able");
+
+PhysicsSnapshotBuffer::PhysicsSnapshotBuffer(int frameCount, int bodyCapacity, int contactCapacity) {
+	frames.resize(frameCount);
+	for (PhysicsSnapshot& s : frames) {
+		s.bodies.reserve(bodyCapacity);
+		s.contacts.reserve(contactCapacity);
+	}
+}
+
+PhysicsSnapshotBuffer::~PhysicsSnapshotBuffer() {
+}
+
+PhysicsSnapshot& PhysicsSnapshotBuffer::BeginSnapshot(int frameID) {
+	PhysicsSnapshot& s = frames[frameID % frames.size()];
+	s.frameID = frameID;
+	s.bodies.clear();
+	s.contacts.clear();
+	return s;
+}
+
+const PhysicsSnapshot* PhysicsSnapshotBuffer::GetSnapshot(int frameID) const {
+	if (frames.empty() || frameID < 0) {
+		return nullptr;
+	}
+	const PhysicsSnapshot& s = frames[frameID % frames.size()];
+	if (s.frameID != frameID) {
+		return nullptr; //overwritten by a newer frame, or never saved
+	}
+	return &s;
+}
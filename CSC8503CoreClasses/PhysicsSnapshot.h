@@ -0,0 +1,51 @@
+#pragma once
+#include "CollisionDetection.h"
+#include <type_traits>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameObject;
+
+		//Everything the physics system needs to put a body back exactly where it was
+		struct BodyState {
+			GameObject* object;
+			Vector3		position;
+			Quaternion	orientation;
+			Vector3		linearVelocity;
+			Vector3		angularVelocity;
+		};
+		//So that a frame's bodies can be copied around as one block
+		static_assert(std::is_trivially_copyable_v<BodyState>, "BodyState must stay trivially copyable");
+
+		struct PhysicsSnapshot {
+			int		frameID			= -1;
+			int		worldStateID	= -1;
+			float	dTOffset		= 0.0f;
+
+			std::vector<BodyState>							bodies;
+			std::vector<CollisionDetection::CollisionInfo>	contacts;
+		};
+
+		/*
+		A fixed size ring of snapshots, indexed by frame ID. Every slot is
+		allocated up front, so saving and restoring a frame never has to
+		touch the heap (unless the world grows past the reserved size).
+		*/
+		class PhysicsSnapshotBuffer {
+		public:
+			PhysicsSnapshotBuffer(int frameCount = 0, int bodyCapacity = 0, int contactCapacity = 0);
+			~PhysicsSnapshotBuffer();
+
+			int GetFrameCount() const {
+				return (int)frames.size();
+			}
+
+			//Returns the (cleared) slot that frameID will be stored in
+			PhysicsSnapshot&		BeginSnapshot(int frameID);
+			const PhysicsSnapshot*	GetSnapshot(int frameID) const;
+
+		protected:
+			std::vector<PhysicsSnapshot> frames;
+		};
+	}
+}
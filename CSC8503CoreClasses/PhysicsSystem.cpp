@@ -7,21 +7,28 @@
 #include "Constraint.h"
 
 #include "Debug.h"
-#include "Window.h"
 #include <functional>
 #include <algorithm>
 using namespace NCL;
 using namespace CSC8503;
 
+//This is the fixed timestep we'd LIKE to have
+const int   idealHZ = 120;
+const float idealDT = 1.0f / idealHZ;
+
 PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)	{
 	applyGravity	= false;
 	useBroadPhase	= true;	
 	dTOffset		= 0.0f;
 	globalDamping	= 0.995f;
+	realHZ			= idealHZ;
+	realDT			= idealDT;
 	SetGravity(Vector3(0.0f, -9.8f, 0.0f));
+	gameWorld.SetObjectRemovedCallback([this](GameObject* o) { RemoveObject(o); });
 }
 
 PhysicsSystem::~PhysicsSystem()	{
+	gameWorld.SetObjectRemovedCallback(nullptr);
 }
 
 void PhysicsSystem::SetGravity(const Vector3& g) {
@@ -43,48 +50,43 @@ void PhysicsSystem::Clear() {
 }
 
 /*
-
-This is the core of the physics engine update
-
+Whatever the object was touching is told the collision has ended, if it
+had been told it started - the object itself is on its way out anyway.
 */
+void PhysicsSystem::RemoveObject(GameObject* o) {
+	for (CollisionDetection::CollisionInfo& i : allCollisions) {
+		if (i.framesLeft == numCollisionFrames) {
+			continue;
+		}
+		if (i.a == o) {
+			i.b->OnCollisionEnd(o);
+		}
+		else if (i.b == o) {
+			i.a->OnCollisionEnd(o);
+		}
+	}
+	allCollisions.erase(
+		std::remove_if(allCollisions.begin(), allCollisions.end(),
+			[&](const CollisionDetection::CollisionInfo& i) { return i.a == o || i.b == o; }),
+		allCollisions.end());
+}
 
-bool useSimpleContainer = false;
-
-int constraintIterationCount = 10;
+/*
 
-//This is the fixed timestep we'd LIKE to have
-const int   idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
+This is the core of the physics engine update
 
-/*
-This is the fixed update we actually have...
-If physics takes too long it starts to kill the framerate, it'll drop the 
-iteration count down until the FPS stabilises, even if that ends up
-being at a low rate. 
 */
-int realHZ		= idealHZ;
-float realDT	= idealDT;
-
 void PhysicsSystem::Update(float dt) {	
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
-		useSimpleContainer = !useSimpleContainer;
-		std::cout << "Setting broad container to " << useSimpleContainer << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
-		constraintIterationCount--;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
-		constraintIterationCount++;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-
 	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
 
+	//The adaptive rate below depends on how long the update took in wall
+	//clock time, so a deterministic world has to stick to the ideal rate
+	bool deterministic = gameWorld.IsDeterministic();
+	if (deterministic) {
+		realHZ = idealHZ;
+		realDT = idealDT;
+	}
+
 	GameTimer t;
 	t.GetTimeDeltaSeconds();
 	
@@ -125,6 +127,9 @@ void PhysicsSystem::Update(float dt) {
 	t.Tick();
 	float updateTime = t.GetTimeDeltaSeconds();
 
+	if (deterministic) {
+		return;
+	}
 	//Uh oh, physics is taking too long...
 	if (updateTime > realDT) {
 		realHZ /= 2;
@@ -158,28 +163,36 @@ OnCollisionBegin / OnCollisionEnd functions (removing health when hit by a
 rocket launcher, gaining a point when the player hits the gold coin, and so on).
 */
 void PhysicsSystem::UpdateCollisionList() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
-		if ((*i).framesLeft == numCollisionFrames) {
-			i->a->OnCollisionBegin(i->b);
-			i->b->OnCollisionBegin(i->a);
+	for (CollisionDetection::CollisionInfo& i : allCollisions) {
+		if (i.framesLeft == numCollisionFrames) {
+			i.a->OnCollisionBegin(i.b);
+			i.b->OnCollisionBegin(i.a);
 		}
 
-		CollisionDetection::CollisionInfo& in = const_cast<CollisionDetection::CollisionInfo&>(*i);
-		in.framesLeft--;
+		i.framesLeft--;
 
-		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
-			i = allCollisions.erase(i);
-		}
-		else {
-			++i;
+		if (i.framesLeft < 0) {
+			i.a->OnCollisionEnd(i.b);
+			i.b->OnCollisionEnd(i.a);
 		}
 	}
+	allCollisions.erase(
+		std::remove_if(allCollisions.begin(), allCollisions.end(),
+			[](const CollisionDetection::CollisionInfo& i) { return i.framesLeft < 0; }),
+		allCollisions.end());
+}
+
+//Behaves like std::set::insert - a pair that's already colliding is left untouched
+void PhysicsSystem::AddCollision(const CollisionDetection::CollisionInfo& info) {
+	auto i = std::lower_bound(allCollisions.begin(), allCollisions.end(), info);
+	if (i != allCollisions.end() && !(info < *i)) {
+		return;
+	}
+	allCollisions.insert(i, info);
 }
 
 void PhysicsSystem::UpdateObjectAABBs() {
-	gameWorld.OperateOnContents(
+	gameWorld.OperateOnPhysicsContents(
 		[](GameObject* g) {
 			g->UpdateBroadphaseAABB();
 		}
@@ -201,16 +214,12 @@ void PhysicsSystem::BasicCollisionDetection()
 
 	std::vector <GameObject*>::const_iterator first;
 	std::vector <GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	gameWorld.GetComponentIterators(ComponentType::Physics, first, last);
 	
 	for (auto i = first; i != last; ++i) 
 	{
-		if ((*i)->GetPhysicsObject() == nullptr) continue;
-
 		for (auto j = i + 1; j != last; ++j) 
 		{
-			if ((*j)->GetPhysicsObject() == nullptr) continue;
-
 			if ((*i)->GetPhysicsObject()->GetInverseMass() + (*j)->GetPhysicsObject()->GetInverseMass() <= 0) continue;
 			CollisionDetection::CollisionInfo info;
 
@@ -224,7 +233,7 @@ void PhysicsSystem::BasicCollisionDetection()
 					ImpulseResolveCollision(*info.a, *info.b, info.point);
 				}
 				info.framesLeft = numCollisionFrames;
-				allCollisions.insert(info);
+				AddCollision(info);
 			}
 		}
 	}
@@ -325,7 +334,7 @@ void PhysicsSystem::BroadPhase()
 
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	gameWorld.GetComponentIterators(ComponentType::Physics, first, last);
 	for (auto i = first; i != last; i++)
 	{
 		Vector3 halfSizes;
@@ -341,8 +350,10 @@ void PhysicsSystem::BroadPhase()
 			{
 				for (auto j = std::next(i); j != data.end(); j++)
 				{
-					info.a = (std::min)((*i).object, (*j).object);
-					info.b = (std::max)((*i).object, (*j).object);
+					//Order each pair by world ID rather than by pointer, so that the
+					//pair (and the order pairs are resolved in) is the same every run
+					bool iFirst = (*i).object->GetWorldID() < (*j).object->GetWorldID();
+					info.SetObjects(iFirst ? (*i).object : (*j).object, iFirst ? (*j).object : (*i).object);
 					broadphaseCollisions.insert(info);
 				}
 			}
@@ -372,7 +383,7 @@ void PhysicsSystem::NarrowPhase()
 				ImpulseResolveCollision(*info.a, *info.b, info.point);
 			}
 			
-			allCollisions.insert(info);
+			AddCollision(info);
 		}
 	}
 }
@@ -390,35 +401,39 @@ void PhysicsSystem::IntegrateAccel(float dt)
 {
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	gameWorld.GetComponentIterators(ComponentType::Physics, first, last);
 
 	for (auto i = first; i != last; i++)
 	{
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) continue;
+		IntegrateObjectAccel(**i, dt);
+	}
 
-		float inverseMass = object->GetInverseMass();
+}
 
-		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
-		Vector3 accel = force * inverseMass;
+void PhysicsSystem::IntegrateObjectAccel(GameObject& o, float dt) 
+{
+	PhysicsObject* object = o.GetPhysicsObject();
 
-		if (applyGravity && inverseMass > 0) accel += (gravity);
+	float inverseMass = object->GetInverseMass();
 
-		linearVel += accel * dt;
-		object->SetLinearVelocity(linearVel);
+	Vector3 linearVel = object->GetLinearVelocity();
+	Vector3 force = object->GetForce();
+	Vector3 accel = force * inverseMass;
 
-		Vector3 torque = object->GetTorque();
-		Vector3 angVel = object->GetAngularVelocity();
+	if (applyGravity && inverseMass > 0) accel += (gravity);
 
-		object->UpdateInertiaTensor();
+	linearVel += accel * dt;
+	object->SetLinearVelocity(linearVel);
 
-		Vector3 angAccell = object->GetInertiaTensor() * torque;
+	Vector3 torque = object->GetTorque();
+	Vector3 angVel = object->GetAngularVelocity();
 
-		angVel += angAccell * dt;
-		object->SetAngularVelocity(angVel);
-	}
+	object->UpdateInertiaTensor();
+
+	Vector3 angAccell = object->GetInertiaTensor() * torque;
 
+	angVel += angAccell * dt;
+	object->SetAngularVelocity(angVel);
 }
 
 /*
@@ -431,49 +446,74 @@ void PhysicsSystem::IntegrateVelocity(float dt)
 {
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	float frameLinearDamping = 1.0f - (0.4f * dt);
+	gameWorld.GetComponentIterators(ComponentType::Physics, first, last);
 
 	for (auto i = first; i != last; i++)
 	{
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) continue;
+		IntegrateObjectVelocity(**i, dt);
+	}
+}
 
-		Transform& transform = (*i)->GetTransform();
+void PhysicsSystem::IntegrateObjectVelocity(GameObject& o, float dt) 
+{
+	PhysicsObject* object = o.GetPhysicsObject();
+
+	Transform& transform = o.GetTransform();
 
-		Vector3 position = transform.GetPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
+	float frameLinearDamping = 1.0f - (0.4f * dt);
 
-		position += linearVel * dt;
-		transform.SetPosition(position);
+	Vector3 position = transform.GetPosition();
+	Vector3 linearVel = object->GetLinearVelocity();
 
-		linearVel = linearVel * frameLinearDamping;
-		object->SetLinearVelocity(linearVel);
+	position += linearVel * dt;
+	transform.SetPosition(position);
 
-		Quaternion orientation = transform.GetOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
+	linearVel = linearVel * frameLinearDamping;
+	object->SetLinearVelocity(linearVel);
 
-		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
-		orientation.Normalise();
+	Quaternion orientation = transform.GetOrientation();
+	Vector3 angVel = object->GetAngularVelocity();
 
-		transform.SetOrientation(orientation);
+	orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
+	orientation.Normalise();
 
-		float frameAngularDamping = 1.0f - (0.4f * dt);
-		angVel = angVel * frameAngularDamping;
-		object->SetAngularVelocity(angVel);
+	transform.SetOrientation(orientation);
+
+	float frameAngularDamping = 1.0f - (0.4f * dt);
+	angVel = angVel * frameAngularDamping;
+	object->SetAngularVelocity(angVel);
+}
+
+/*
+Moves a single object along on its own, using the same fixed timestep
+integration as a full update, but without any collision detection. This
+is what clients use to replay their inputs over a corrected player state.
+*/
+void PhysicsSystem::UpdateObject(GameObject& o, float dt) 
+{
+	if (!o.GetPhysicsObject()) {
+		return;
+	}
+	int steps		= std::max(1, (int)std::round(dt / idealDT));
+	float stepDT	= dt / steps;
+	for (int i = 0; i < steps; ++i) {
+		IntegrateObjectAccel(o, stepDT);
+		IntegrateObjectVelocity(o, stepDT);
 	}
+	o.GetPhysicsObject()->ClearForces();
 }
 void PhysicsSystem::DrawHitboxes() {
-	gameWorld.OperateOnContents(
+	gameWorld.OperateOnPhysicsContents(
 		[](GameObject* o) {
-			o->DrawHitbox();
+			if (o->GetBoundingVolume()) {
+				o->DrawHitbox();
+			}
 		}
 	);
 }
 
 void PhysicsSystem::ResetIsCollidings() {
-	gameWorld.OperateOnContents(
+	gameWorld.OperateOnPhysicsContents(
 		[](GameObject* o) {
 			o->SetColliding(false);
 
@@ -486,10 +526,9 @@ clear out any accumulated forces, ready to receive new
 ones in the next 'game' frame.
 */
 void PhysicsSystem::ClearForces() {
-	gameWorld.OperateOnContents(
+	gameWorld.OperateOnPhysicsContents(
 		[](GameObject* o) {
 			o->GetPhysicsObject()->ClearForces();
-			
 		}
 	);
 }
@@ -510,4 +549,60 @@ void PhysicsSystem::UpdateConstraints(float dt) {
 	for (auto i = first; i != last; ++i) {
 		(*i)->UpdateConstraint(dt);
 	}
-}
\ No newline at end of file
+}
+
+/*
+Snapshots store a copy of each physics body's state in the same order as
+the world's physics list, along with the contact cache, so that a frame
+can be rolled back to for network reconciliation or replays.
+*/
+void PhysicsSystem::SetSnapshotCapacity(int frameCount, int bodyCapacity, int contactCapacity) {
+	snapshots = PhysicsSnapshotBuffer(frameCount, bodyCapacity, contactCapacity);
+	allCollisions.reserve(contactCapacity);
+}
+
+bool PhysicsSystem::SaveSnapshot(int frameID) {
+	if (snapshots.GetFrameCount() == 0) {
+		return false;
+	}
+	PhysicsSnapshot& snapshot = snapshots.BeginSnapshot(frameID);
+	snapshot.worldStateID	= gameWorld.GetWorldStateID();
+	snapshot.dTOffset		= dTOffset;
+
+	gameWorld.OperateOnPhysicsContents(
+		[&](GameObject* o) {
+			const PhysicsObject* object = o->GetPhysicsObject();
+			const Transform& transform	= o->GetTransform();
+			snapshot.bodies.push_back({
+				o,
+				transform.GetPosition(),
+				transform.GetOrientation(),
+				object->GetLinearVelocity(),
+				object->GetAngularVelocity()
+			});
+		}
+	);
+	snapshot.contacts.assign(allCollisions.begin(), allCollisions.end());
+	return true;
+}
+
+bool PhysicsSystem::RestoreSnapshot(int frameID) {
+	const PhysicsSnapshot* snapshot = snapshots.GetSnapshot(frameID);
+	if (!snapshot || snapshot->worldStateID != gameWorld.GetWorldStateID()) {
+		return false;
+	}
+	for (const BodyState& body : snapshot->bodies) {
+		Transform& transform	= body.object->GetTransform();
+		PhysicsObject* object	= body.object->GetPhysicsObject();
+
+		transform.SetPosition(body.position);
+		transform.SetOrientation(body.orientation);
+		object->SetLinearVelocity(body.linearVelocity);
+		object->SetAngularVelocity(body.angularVelocity);
+		object->ClearForces();
+	}
+	//allCollisions keeps its capacity, so this is normally just a copy
+	allCollisions.assign(snapshot->contacts.begin(), snapshot->contacts.end());
+	dTOffset = snapshot->dTOffset;
+	return true;
+}
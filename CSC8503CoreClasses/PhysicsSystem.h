@@ -1,5 +1,6 @@
 #pragma once
 #include "GameWorld.h"
+#include "PhysicsSnapshot.h"
 
 namespace NCL {
 	namespace CSC8503 {
@@ -26,6 +27,39 @@ namespace NCL {
 			{
 				drawHitboxes = !drawHitboxes;
 			}
+
+			void ToggleBroadPhase() {
+				useBroadPhase = !useBroadPhase;
+				std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
+			}
+
+			void ToggleSimpleContainer() {
+				useSimpleContainer = !useSimpleContainer;
+				std::cout << "Setting broad container to " << useSimpleContainer << std::endl;
+			}
+
+			void SetConstraintIterationCount(int count) {
+				constraintIterationCount = std::max(1, count);
+				std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
+			}
+
+			int GetConstraintIterationCount() const {
+				return constraintIterationCount;
+			}
+
+			//Rollback support - every body's transform and velocities, plus the
+			//contact cache, can be saved into a ring of the last N frames
+			void SetSnapshotCapacity(int frameCount, int bodyCapacity = 256, int contactCapacity = 256);
+			bool SaveSnapshot(int frameID);
+			//Fails if the frame has been overwritten, or objects have been
+			//added to / removed from the world, or had their components
+			//changed, since it was saved
+			bool RestoreSnapshot(int frameID);
+
+			//Integrates one body on its own, with no collision response
+			void UpdateObject(GameObject& o, float dt);
+			//Ends any collisions an object is in - the world calls this for everything it removes
+			void RemoveObject(GameObject* o);
 		protected:
 			void BasicCollisionDetection();
 			void BroadPhase();
@@ -37,10 +71,13 @@ namespace NCL {
 
 			void IntegrateAccel(float dt);
 			void IntegrateVelocity(float dt);
+			void IntegrateObjectAccel(GameObject& o, float dt);
+			void IntegrateObjectVelocity(GameObject& o, float dt);
 
 			void UpdateConstraints(float dt);
 
 			void UpdateCollisionList();
+			void AddCollision(const CollisionDetection::CollisionInfo& info);
 			void UpdateObjectAABBs();
 
 			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
@@ -51,12 +88,26 @@ namespace NCL {
 			float	dTOffset;
 			float	globalDamping;
 
-			std::set<CollisionDetection::CollisionInfo> allCollisions;
+			/*
+			This is the fixed update we actually have...
+			If physics takes too long it starts to kill the framerate, it'll drop the 
+			iteration count down until the FPS stabilises, even if that ends up
+			being at a low rate. 
+			*/
+			int		realHZ;
+			float	realDT;
+
+			//Kept sorted, so it can be searched like a set but copied like an array
+			std::vector<CollisionDetection::CollisionInfo> allCollisions;
 			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
 			std::vector<CollisionDetection::CollisionInfo> broadphaseCollisionsVec;
 			bool useBroadPhase		= true;
+			bool useSimpleContainer	= false;
+			int constraintIterationCount = 10;
 			int numCollisionFrames	= 5;
 			bool drawHitboxes = false;
+
+			PhysicsSnapshotBuffer snapshots;
 		};
 	}
 }
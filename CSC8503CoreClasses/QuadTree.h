@@ -107,6 +107,26 @@ namespace NCL {
 				}
 			}
 
+			//As above, but only for leaves that overlap the given area
+			void OperateOnRegion(const Vector3& regionPos, const Vector3& regionSize, QuadTreeFunc& func) 
+			{
+				if (!CollisionDetection::AABBTest(regionPos, Vector3(position.x, 0, position.y), regionSize, Vector3(size.x, 1000.0f, size.y)))
+				{
+					return;
+				}
+				if (children)
+				{
+					for (int i = 0; i < 4; i++)
+					{
+						children[i].OperateOnRegion(regionPos, regionSize, func);
+					}
+				}
+				else if (!contents.empty())
+				{
+					func(contents);
+				}
+			}
+
 		protected:
 			std::list< QuadTreeEntry<T> >	contents;
 
@@ -146,6 +166,11 @@ namespace NCL {
 				root.OperateOnContents(func);
 			}
 
+			//Objects that span several leaves will be seen more than once
+			void OperateOnRegion(const Vector3& pos, const Vector3& halfSize, typename QuadTreeNode<T>::QuadTreeFunc func) {
+				root.OperateOnRegion(pos, halfSize, func);
+			}
+
 		protected:
 			QuadTreeNode<T> root;
 			int maxDepth;
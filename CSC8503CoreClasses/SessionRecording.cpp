@@ -0,0 +1,182 @@
+#include "SessionRecording.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+static_assert(sizeof(SessionFileHeader) % 4 == 0 && sizeof(SessionRecord) % 4 == 0, "records must stay 4 byte aligned");
+
+static size_t PaddedSize(size_t size) {
+	return (size + 3) & ~(size_t)3;
+}
+
+SessionRecorder::SessionRecorder() {
+	bytesWritten = 0;
+}
+
+SessionRecorder::~SessionRecorder() {
+	Close();
+}
+
+bool SessionRecorder::Open(const std::string& filename, float tickRate, const StateQuantisation& q) {
+	std::lock_guard<std::mutex> guard(lock);
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cout << __FUNCTION__ << " couldn't open " << filename << std::endl;
+		return false;
+	}
+	SessionFileHeader header;
+	header.tickRate		= tickRate;
+	header.quantisation	= q;
+	file.write((const char*)&header, sizeof(header));
+	bytesWritten = sizeof(header);
+	return true;
+}
+
+void SessionRecorder::Close() {
+	std::lock_guard<std::mutex> guard(lock);
+	if (file.is_open()) {
+		file.close();
+	}
+}
+
+void SessionRecorder::RecordTick(int tick) {
+	Write(SessionRecord::Tick, tick, -1, nullptr);
+}
+
+void SessionRecorder::RecordIncoming(int tick, int peer, const GamePacket& packet) {
+	Write(SessionRecord::Incoming, tick, peer, &packet);
+}
+
+void SessionRecorder::RecordOutgoing(int tick, int peer, const GamePacket& packet) {
+	Write(SessionRecord::Outgoing, tick, peer, &packet);
+}
+
+void SessionRecorder::Write(SessionRecord::Kind kind, int tick, int peer, const GamePacket* packet) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!file.is_open()) {
+		return;
+	}
+	SessionRecord record = {};
+	record.tick		= tick;
+	record.peer		= (int16_t)peer;
+	record.size		= packet ? (uint16_t)(sizeof(GamePacket) + packet->size) : 0;
+	record.kind		= kind;
+	file.write((const char*)&record, sizeof(record));
+
+	if (packet) {
+		static const char zeroes[4] = { 0, 0, 0, 0 };
+		file.write((const char*)packet, record.size);
+		file.write(zeroes, PaddedSize(record.size) - record.size);
+	}
+	bytesWritten += sizeof(record) + PaddedSize(record.size);
+}
+
+SessionPlayback::SessionPlayback() {
+	data			= nullptr;
+	size			= 0;
+	position		= 0;
+	fileHandle		= nullptr;
+	mappingHandle	= nullptr;
+}
+
+SessionPlayback::~SessionPlayback() {
+	Close();
+}
+
+bool SessionPlayback::Open(const std::string& filename) {
+	Close();
+#ifdef _WIN32
+	HANDLE f = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (f == INVALID_HANDLE_VALUE) {
+		std::cout << __FUNCTION__ << " couldn't open " << filename << std::endl;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(f, &fileSize);
+	HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	fileHandle		= f;
+	mappingHandle	= mapping;
+	size			= (size_t)fileSize.QuadPart;
+#else
+	int f = open(filename.c_str(), O_RDONLY);
+	if (f < 0) {
+		std::cout << __FUNCTION__ << " couldn't open " << filename << std::endl;
+		return false;
+	}
+	struct stat info;
+	fstat(f, &info);
+	size = (size_t)info.st_size;
+	void* view = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, f, 0) : MAP_FAILED;
+	close(f); //the mapping keeps the file open
+	if (view == MAP_FAILED) {
+		view = nullptr;
+	}
+#endif
+	data = (const char*)view;
+	if (!data || size < sizeof(SessionFileHeader)) {
+		std::cout << __FUNCTION__ << " " << filename << " is empty or couldn't be mapped" << std::endl;
+		Close();
+		return false;
+	}
+	const SessionFileHeader& header = GetHeader();
+	if (memcmp(header.magic, SessionFileHeader().magic, 4) != 0 || header.version != SessionFileHeader::CurrentVersion) {
+		std::cout << __FUNCTION__ << " " << filename << " isn't a session recording this build can read" << std::endl;
+		Close();
+		return false;
+	}
+	Rewind();
+	return true;
+}
+
+void SessionPlayback::Close() {
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle) {
+		CloseHandle((HANDLE)mappingHandle);
+	}
+	if (fileHandle) {
+		CloseHandle((HANDLE)fileHandle);
+	}
+#else
+	if (data) {
+		munmap((void*)data, size);
+	}
+#endif
+	data			= nullptr;
+	size			= 0;
+	position		= 0;
+	fileHandle		= nullptr;
+	mappingHandle	= nullptr;
+}
+
+bool SessionPlayback::Next(Record& record) {
+	if (!data || position + sizeof(SessionRecord) > size) {
+		return false;
+	}
+	const SessionRecord& r = *(const SessionRecord*)(data + position);
+	size_t next = position + sizeof(SessionRecord) + PaddedSize(r.size);
+	if (next > size || r.kind > SessionRecord::Outgoing || (r.size > 0 && r.size < sizeof(GamePacket))) {
+		return false;
+	}
+	record.kind		= (SessionRecord::Kind)r.kind;
+	record.tick		= r.tick;
+	record.peer		= r.peer;
+	record.packet	= r.size > 0 ? (const GamePacket*)(data + position + sizeof(SessionRecord)) : nullptr;
+	if (record.packet && sizeof(GamePacket) + record.packet->size != r.size) {
+		return false;
+	}
+	position = next;
+	return true;
+}
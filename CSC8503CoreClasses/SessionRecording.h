@@ -0,0 +1,110 @@
+#pragma once
+#include "NetworkBase.h"
+#include "NetworkState.h"
+#include <mutex>
+#include <fstream>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A recorded session is a SessionFileHeader, then SessionRecords back to
+		back, each followed by the packet it's about (if it has one), padded
+		to 4 bytes. Everything is stored as it was in memory, so a file is
+		only readable by a build for the same kind of machine - that's all
+		it needs, as it's for replaying, not for keeping.
+		*/
+		struct SessionFileHeader {
+			static const uint32_t CurrentVersion = 1;
+
+			char				magic[4]	= { 'N', 'C', 'S', 'R' };
+			uint32_t			version		= CurrentVersion;
+			float				tickRate	= 0.0f;
+			StateQuantisation	quantisation;
+		};
+
+		struct SessionRecord {
+			enum Kind : uint8_t {
+				Tick,		//the server simulated a tick, then sent that tick's snapshots
+				Incoming,	//a packet a client sent the server - or a connection / disconnection
+				Outgoing	//a snapshot datagram the server sent
+			};
+			int32_t		tick;	//the server tick it belongs to - for incoming packets, the next tick to run
+			int16_t		peer;
+			uint16_t	size;	//of the packet following, GamePacket header included
+			uint8_t		kind;
+			uint8_t		padding[3];
+		};
+
+		/*
+		Writes a server's side of a session to a file - every tick, and every
+		packet that goes in or comes out, in the order it happened. Snapshots
+		can be written on the snapshot thread while packets come in on the
+		main thread, so it's safe to record from both.
+		*/
+		class SessionRecorder {
+		public:
+			SessionRecorder();
+			~SessionRecorder();
+
+			bool Open(const std::string& filename, float tickRate, const StateQuantisation& q);
+			void Close();
+			bool IsOpen() const {
+				return file.is_open();
+			}
+
+			void RecordTick(int tick);
+			void RecordIncoming(int tick, int peer, const GamePacket& packet);
+			void RecordOutgoing(int tick, int peer, const GamePacket& packet);
+
+			int64_t GetBytesWritten() const {
+				return bytesWritten;
+			}
+
+		protected:
+			void Write(SessionRecord::Kind kind, int tick, int peer, const GamePacket* packet);
+
+			std::mutex		lock;
+			std::ofstream	file;
+			int64_t			bytesWritten;
+		};
+
+		/*
+		Reads a recorded session back. The file is mapped into memory rather
+		than read in, so even a long session opens straight away, and each
+		record's packet is handed out where it lies in the file.
+		*/
+		class SessionPlayback {
+		public:
+			struct Record {
+				SessionRecord::Kind	kind;
+				int					tick;
+				int					peer;
+				const GamePacket*	packet;	//null for ticks
+			};
+
+			SessionPlayback();
+			~SessionPlayback();
+
+			bool Open(const std::string& filename);
+			void Close();
+
+			const SessionFileHeader& GetHeader() const {
+				return *(const SessionFileHeader*)data;
+			}
+
+			//False at the end of the file, or if the rest of it is damaged
+			bool Next(Record& record);
+			void Rewind() {
+				position = sizeof(SessionFileHeader);
+			}
+
+		protected:
+			const char*	data;
+			size_t		size;
+			size_t		position;
+
+			void*		fileHandle;		//only used on Windows
+			void*		mappingHandle;
+		};
+	}
+}
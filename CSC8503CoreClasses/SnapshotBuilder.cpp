@@ -0,0 +1,265 @@
+#include "SnapshotBuilder.h"
+#include "GameServer.h"
+#include "NetworkStats.h"
+#include "SessionRecording.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+//How often each byte turned up in the packed entries of recorded snapshots - see CSC8503NetBench
+static const uint32_t snapshotByteFrequencies[HuffmanCodec::SymbolCount] = {
+	49081, 15162, 24528, 9849, 4150, 3285, 2003, 7861, 6276, 2877, 2174, 12320, 1472, 3340, 3800, 3224,
+	11865, 5459, 2328, 1624, 2110, 1794, 2871, 1706, 2140, 1353, 2325, 2607, 1443, 1060, 4219, 3038,
+	7258, 10665, 2102, 760, 1389, 802, 2632, 789, 4726, 740, 1938, 558, 1537, 10321, 1648, 1022,
+	1534, 1002, 2260, 1183, 1884, 2198, 1386, 949, 1323, 1086, 3938, 1024, 1701, 1135, 1485, 1148,
+	13154, 1209, 2353, 1058, 1485, 1755, 1642, 1149, 5391, 652, 1837, 900, 2443, 746, 1331, 710,
+	3094, 2030, 2415, 1572, 3084, 3174, 1195, 1021, 2772, 2938, 3296, 798, 1310, 2233, 1039, 722,
+	2754, 675, 1880, 917, 1088, 2532, 1216, 909, 4426, 1062, 2315, 886, 1612, 1622, 1931, 1156,
+	1755, 1614, 2207, 1363, 1676, 1109, 821, 452, 1323, 632, 1985, 771, 1425, 791, 1176, 2662,
+	12115, 2744, 4261, 2531, 11132, 728, 991, 755, 3816, 537, 1942, 606, 1097, 689, 1122, 819,
+	1648, 879, 2066, 1195, 3178, 657, 1225, 885, 4588, 1054, 2030, 763, 1122, 795, 2917, 872,
+	7153, 10403, 2005, 723, 1078, 941, 2300, 755, 7606, 1031, 2036, 701, 1092, 783, 1244, 977,
+	1647, 662, 1948, 713, 4608, 6707, 957, 734, 1425, 734, 3666, 657, 952, 625, 920, 516,
+	2860, 616, 1750, 586, 946, 535, 947, 1138, 4239, 688, 2007, 750, 1122, 1184, 2519, 1111,
+	1921, 910, 2312, 3758, 6070, 3941, 4823, 5239, 1375, 462, 1545, 613, 893, 491, 768, 515,
+	4555, 653, 1860, 505, 784, 552, 1387, 1774, 4880, 2507, 4053, 1506, 1252, 805, 1092, 775,
+	1583, 724, 1751, 727, 1169, 816, 914, 630, 3164, 741, 1827, 800, 1221, 720, 1157, 605
+};
+
+static int32_t	ZigZagDecode(uint32_t v) {
+	return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static uint32_t ZigZagEncode(int32_t v) {
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+void SnapshotEntry::Write(BitWriter& stream, const StateQuantisation& q) const {
+	stream.WriteVarUInt(objectID);
+	stream.WriteBool(fullState);
+	if (fullState) {
+		for (int i = 0; i < 3; ++i) {
+			stream.WriteBits(state.position[i], q.positionBits);
+		}
+		stream.WriteBits(state.orientation, 2 + q.orientationBits * 3);
+		return;
+	}
+	stream.WriteVarUInt(baselineOffset);
+	stream.WriteBool(hasPosition);
+	if (hasPosition) {
+		stream.WriteBool(smallPosition);
+		for (int i = 0; i < 3; ++i) {
+			if (smallPosition) {
+				stream.WriteBits(ZigZagEncode(positionDelta[i]), q.smallDeltaBits);
+			}
+			else {
+				stream.WriteBits(state.position[i], q.positionBits);
+			}
+		}
+	}
+	stream.WriteBool(hasOrientation);
+	if (hasOrientation) {
+		stream.WriteBits(state.orientation, 2 + q.orientationBits * 3);
+	}
+}
+
+void SnapshotEntry::Read(BitReader& stream, const StateQuantisation& q) {
+	objectID	= stream.ReadVarNonNegative();
+	fullState	= stream.ReadBool();
+	if (fullState) {
+		hasPosition		= true;
+		hasOrientation	= true;
+		for (int i = 0; i < 3; ++i) {
+			state.position[i] = stream.ReadBits(q.positionBits);
+		}
+		state.orientation = stream.ReadBits(2 + q.orientationBits * 3);
+		return;
+	}
+	baselineOffset	= stream.ReadVarNonNegative();
+	hasPosition		= stream.ReadBool();
+	if (hasPosition) {
+		smallPosition = stream.ReadBool();
+		for (int i = 0; i < 3; ++i) {
+			if (smallPosition) {
+				positionDelta[i] = ZigZagDecode(stream.ReadBits(q.smallDeltaBits));
+			}
+			else {
+				state.position[i] = stream.ReadBits(q.positionBits);
+			}
+		}
+	}
+	hasOrientation = stream.ReadBool();
+	if (hasOrientation) {
+		state.orientation = stream.ReadBits(2 + q.orientationBits * 3);
+	}
+}
+
+SnapshotBuilder::SnapshotBuilder(int maxPacketSize) {
+	this->maxPacketSize = maxPacketSize;
+	buffer.resize(maxPacketSize);
+	entryBuffer.resize(64); //far more than the largest entry
+	uncompressedBuffer.resize(maxPacketSize);
+	compress	= false;
+
+	entryCount	= 0;
+	server		= nullptr;
+	recorder	= nullptr;
+	peerID		= -1;
+	packetsSent		= 0;
+	bytesSent		= 0;
+	snapshotBytes	= 0;
+	fullEntries		= 0;
+	deltaEntries	= 0;
+}
+
+SnapshotBuilder::~SnapshotBuilder() {
+}
+
+void SnapshotBuilder::Begin(GameServer& server, int peerID, const SnapshotHeader& header) {
+	this->server = &server;
+	this->peerID = peerID;
+	this->header = header;
+	snapshotBytes	= 0;
+	fullEntries		= 0;
+	deltaEntries	= 0;
+	BeginPacket();
+}
+
+void SnapshotBuilder::BeginPacket() {
+	new (buffer.data()) SnapshotPacket();
+	packetStream.Reset(buffer.data() + sizeof(GamePacket), maxPacketSize - sizeof(GamePacket));
+	WriteHeader(packetStream, header);
+	uncompressedStream.Reset(uncompressedBuffer.data(), (int)uncompressedBuffer.size());
+	entryCount = 0;
+}
+
+int SnapshotBuilder::AddEntry(const SnapshotEntry& entry) {
+	entryStream.Reset(entryBuffer.data(), (int)entryBuffer.size());
+	entry.Write(entryStream, quantisation);
+
+	int capacityBits = (maxPacketSize - (int)sizeof(GamePacket)) * 8;
+	if (entryCount > 0 && packetStream.GetBitsWritten() + entryStream.GetBitsWritten() > capacityBits) {
+		Flush();
+		header.sequence++;
+		BeginPacket();
+	}
+	packetStream.WriteStream(entryStream);
+	if (compress) {
+		uncompressedStream.WriteStream(entryStream);
+	}
+	entryCount++;
+	(entry.fullState ? fullEntries : deltaEntries)++;
+	return header.sequence;
+}
+
+void SnapshotBuilder::End() {
+	Flush();
+	if (entryCount > 0) {
+		header.sequence++;
+	}
+	if (server) {
+		server->GetStats().RecordSnapshotEntries(fullEntries, deltaEntries);
+	}
+	entryCount	= 0;
+	server		= nullptr;
+}
+
+void SnapshotBuilder::Flush() {
+	if (entryCount == 0 || !server) {
+		return;
+	}
+	if (compress) {
+		CompressPacket();
+	}
+	packetStream.Flush();
+
+	SnapshotPacket* packet = (SnapshotPacket*)buffer.data();
+	packet->size = (short)packetStream.GetBytesWritten();
+
+	if (peerID < 0) {
+		server->SendGlobalPacket(*packet);
+	}
+	else {
+		server->SendPacketToPeer(peerID, *packet);
+	}
+	if (recorder) {
+		recorder->RecordOutgoing(header.stateID, peerID, *packet);
+	}
+	packetsSent++;
+	bytesSent		+= packet->GetTotalSize();
+	snapshotBytes	+= packet->GetTotalSize();
+}
+
+void SnapshotBuilder::WriteHeader(BitWriter& stream, const SnapshotHeader& header) {
+	stream.WriteVarUInt(header.sequence);
+	stream.WriteVarUInt(header.stateID);
+	stream.WriteBool(header.compressed);
+}
+
+/*
+The entries are packed down to the bit, so there isn't a great deal of
+redundancy left to find - but most of what's sent is small deltas of
+objects that have barely moved, and their bytes are far from random.
+The packet is only rewritten if the Huffman coded entries come out
+smaller than they already are.
+*/
+void SnapshotBuilder::CompressPacket() {
+	uncompressedStream.Flush();
+	int entryBytes	= uncompressedStream.GetBytesWritten();
+	int rawBits		= packetStream.GetBitsWritten();
+
+	BitWriter sizeCounter;
+	sizeCounter.WriteVarUInt(entryBytes);
+
+	SnapshotHeader compressedHeader = header;
+	compressedHeader.compressed = true;
+
+	BitWriter headerCounter;
+	WriteHeader(headerCounter, compressedHeader);
+
+	const HuffmanCodec& codec = GetCodec();
+	int compressedBits = headerCounter.GetBitsWritten() + sizeCounter.GetBitsWritten() + codec.GetEncodedBits(uncompressedBuffer.data(), entryBytes);
+	if (compressedBits >= rawBits) {
+		return;
+	}
+	packetStream.Reset(buffer.data() + sizeof(GamePacket), maxPacketSize - sizeof(GamePacket));
+	WriteHeader(packetStream, compressedHeader);
+	packetStream.WriteVarUInt(entryBytes);
+	codec.Encode(uncompressedBuffer.data(), entryBytes, packetStream);
+}
+
+bool SnapshotBuilder::DecompressEntries(BitReader& stream, std::vector<char>& entryBytes) {
+	int byteCount = stream.ReadVarNonNegative();
+	if (byteCount > 0xFFFF || stream.HasOverflowed()) {
+		return false; //no snapshot datagram is anywhere near this big
+	}
+	entryBytes.resize(byteCount);
+	return GetCodec().Decode(stream, entryBytes.data(), byteCount);
+}
+
+bool SnapshotBuilder::ReadEntryBytes(GamePacket& snapshot, std::vector<char>& entryBytes) {
+	BitReader stream((char*)&snapshot + sizeof(GamePacket), snapshot.size);
+	SnapshotHeader header = ReadHeader(stream);
+	if (header.compressed) {
+		return DecompressEntries(stream, entryBytes);
+	}
+	//Not byte aligned after the header, so they're copied out a byte at a time
+	entryBytes.clear();
+	while (stream.GetBitsRemaining() >= 8) {
+		entryBytes.push_back((char)stream.ReadBits(8));
+	}
+	int bits = stream.GetBitsRemaining();
+	if (bits > 0) {
+		entryBytes.push_back((char)stream.ReadBits(bits));
+	}
+	return !stream.HasOverflowed();
+}
+
+const HuffmanCodec& SnapshotBuilder::GetCodec() {
+	static HuffmanCodec codec = [] {
+		HuffmanCodec c;
+		c.Build(snapshotByteFrequencies);
+		return c;
+	}();
+	return codec;
+}
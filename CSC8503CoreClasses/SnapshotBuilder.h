@@ -0,0 +1,180 @@
+#pragma once
+#include "NetworkBase.h"
+#include "NetworkState.h"
+#include "BitStream.h"
+#include "HuffmanCodec.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameServer;
+		class SessionRecorder;
+
+		//Followed by a bit packed SnapshotHeader, then SnapshotEntries until the end of the packet -
+		//or if the header says they're compressed, their byte count and then the Huffman coded bytes
+		struct SnapshotPacket : public GamePacket {
+			SnapshotPacket() {
+				type = Snapshot_State;
+				size = 0;
+			}
+		};
+
+		struct SnapshotHeader {
+			int sequence	= 0;	//counts up with every datagram sent to a client, so it can acknowledge them
+			int stateID		= -1;	//the server tick - full entries are stored under this ID
+			bool compressed	= false;
+		};
+
+		/*
+		One object's state within a snapshot. Full entries always carry the
+		whole quantised state. Delta entries only carry what's changed since
+		their baseline (baselineOffset ticks before the snapshot's state), with
+		small position changes sent as offsets from it - and objects that haven't
+		changed at all aren't sent in the first place.
+		*/
+		struct SnapshotEntry {
+			int			objectID		= -1;
+			bool		fullState		= false;
+			int			baselineOffset	= 0;
+			bool		hasPosition		= false;
+			bool		smallPosition	= false;
+			bool		hasOrientation	= false;
+			int			positionDelta[3] = { 0, 0, 0 };
+			QuantisedState state;
+
+			void Write(BitWriter& stream, const StateQuantisation& q) const;
+			void Read(BitReader& stream, const StateQuantisation& q);
+		};
+
+		/*
+		Packs a tick's worth of object states back to back into as few
+		datagrams as possible, rather than sending one tiny ENet packet per
+		object. Entries are bit packed into a buffer that's reused from tick
+		to tick, and a datagram is sent whenever the next entry wouldn't fit
+		in the MTU.
+		*/
+		class SnapshotBuilder {
+		public:
+			//Leaves room for the UDP / ENet headers within a typical 1500 byte MTU
+			static const int DefaultMaxPacketSize = 1200;
+
+			SnapshotBuilder(int maxPacketSize = DefaultMaxPacketSize);
+			~SnapshotBuilder();
+
+			void SetQuantisation(const StateQuantisation& q) {
+				quantisation = q;
+			}
+			const StateQuantisation& GetQuantisation() const {
+				return quantisation;
+			}
+
+			//Each datagram's entries are Huffman coded if that makes them any smaller
+			void SetCompression(bool state) {
+				compress = state;
+			}
+			//Trained on recorded snapshots - the same at both ends, so nothing about it is sent
+			static const HuffmanCodec& GetCodec();
+
+			//Every datagram sent is also written to the recorder, if there is one
+			void SetRecorder(SessionRecorder* r) {
+				recorder = r;
+			}
+
+			//peerID of -1 broadcasts to every client
+			void Begin(GameServer& server, int peerID, const SnapshotHeader& header);
+			//Returns the sequence number of the datagram the entry went into
+			int  AddEntry(const SnapshotEntry& entry);
+			void End();
+
+			const SnapshotHeader& GetHeader() const {
+				return header;
+			}
+			//The sequence the next datagram would be sent with
+			int GetNextSequence() const {
+				return entryCount > 0 ? header.sequence + 1 : header.sequence;
+			}
+			//Everything written since Begin, including what's still waiting to be sent
+			int GetSnapshotBytes() const {
+				return snapshotBytes + (entryCount > 0 ? (int)sizeof(GamePacket) + packetStream.GetBytesWritten() : 0);
+			}
+
+			//Just the header of a received Snapshot_State packet, to see if it's worth reading the rest
+			static SnapshotHeader ReadHeader(GamePacket& snapshot) {
+				BitReader stream((char*)&snapshot + sizeof(GamePacket), snapshot.size);
+				return ReadHeader(stream);
+			}
+
+			//Calls func(header, entry) on every entry of a received Snapshot_State packet
+			template<typename Func>
+			static void ReadEntries(GamePacket& snapshot, const StateQuantisation& q, Func&& func) {
+				BitReader stream((char*)&snapshot + sizeof(GamePacket), snapshot.size);
+				SnapshotHeader header = ReadHeader(stream);
+				if (header.compressed) {
+					thread_local std::vector<char> entryBytes;
+					if (!DecompressEntries(stream, entryBytes)) {
+						return;
+					}
+					stream = BitReader(entryBytes.data(), (int)entryBytes.size());
+				}
+				//Entries are at least a byte, anything less is padding
+				while (stream.GetBitsRemaining() >= 8) {
+					SnapshotEntry entry;
+					entry.Read(stream, q);
+					if (stream.HasOverflowed()) {
+						return; //truncated or malformed
+					}
+					func(header, entry);
+				}
+			}
+
+			//The packed entries of a received Snapshot_State packet, decompressed if they need to be
+			static bool ReadEntryBytes(GamePacket& snapshot, std::vector<char>& entryBytes);
+
+			int GetPacketsSent() const {
+				return packetsSent;
+			}
+			int GetBytesSent() const {
+				return bytesSent;
+			}
+
+		protected:
+			static SnapshotHeader ReadHeader(BitReader& stream) {
+				SnapshotHeader header;
+				header.sequence		= stream.ReadVarNonNegative();
+				header.stateID		= stream.ReadVarNonNegative();
+				header.compressed	= stream.ReadBool();
+				return header;
+			}
+			static void WriteHeader(BitWriter& stream, const SnapshotHeader& header);
+			static bool DecompressEntries(BitReader& stream, std::vector<char>& entryBytes);
+
+			void	BeginPacket();
+			void	CompressPacket();
+			void	Flush();
+
+			StateQuantisation quantisation;
+
+			std::vector<char> buffer;
+			BitWriter	packetStream;
+			int			maxPacketSize;
+			int			entryCount;
+
+			std::vector<char> entryBuffer;
+			BitWriter	entryStream;
+
+			bool		compress;
+			std::vector<char> uncompressedBuffer;	//the current datagram's entries on their own, byte aligned
+			BitWriter	uncompressedStream;
+
+			GameServer*		server;
+			SessionRecorder* recorder;
+			int				peerID;
+			SnapshotHeader	header;
+
+			int packetsSent;
+			int bytesSent;
+			int snapshotBytes;
+			int fullEntries;	//in this snapshot, passed on to the server's stats at End
+			int deltaEntries;
+		};
+	}
+}
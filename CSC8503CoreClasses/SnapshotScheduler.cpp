@@ -0,0 +1,179 @@
+#include "SnapshotScheduler.h"
+#include "SnapshotBuilder.h"
+#include "InterestManager.h"
+#include "GameServer.h"
+#include "GameObject.h"
+#include "NetworkObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+SnapshotScheduler::SnapshotScheduler(int bytesPerSecond, float tickRate) {
+	this->bytesPerSecond	= bytesPerSecond;
+	this->tickRate			= tickRate;
+	velocityWeight			= 0.1f;
+	farPriority				= 0.1f;
+}
+
+SnapshotScheduler::~SnapshotScheduler() {
+}
+
+void SnapshotScheduler::AddPeer(int peerID) {
+	PeerRecord& peer = peers[peerID];
+	peer = PeerRecord();
+	peer.sentPackets.resize(SentPacketCount);
+}
+
+void SnapshotScheduler::RemovePeer(int peerID) {
+	peers.erase(peerID);
+}
+
+SnapshotScheduler::ObjectRecord& SnapshotScheduler::GetObjectRecord(PeerRecord& peer, int networkID) {
+	if (networkID >= (int)peer.objects.size()) {
+		peer.objects.resize(networkID + 1);
+	}
+	return peer.objects[networkID];
+}
+
+void SnapshotScheduler::OnAcknowledged(int peerID, int sequence, uint32_t ackBits) {
+	auto i = peers.find(peerID);
+	if (i == peers.end() || sequence < 0) {
+		return;
+	}
+	PeerRecord& peer = i->second;
+
+	for (int n = 0; n <= 32; ++n) {
+		if (n > 0 && !(ackBits & (1u << (n - 1)))) {
+			continue;
+		}
+		int ackedSequence = sequence - n;
+		if (ackedSequence < 0) {
+			break;
+		}
+		SentPacket& p = peer.sentPackets[ackedSequence % SentPacketCount];
+		if (p.sequence != ackedSequence || p.acked) {
+			continue;
+		}
+		p.acked = true;
+		for (const auto& [networkID, stateID] : p.fullStates) {
+			ObjectRecord& o = GetObjectRecord(peer, networkID);
+			o.confirmedState = std::max(o.confirmedState, stateID);
+		}
+	}
+}
+
+/*
+Acknowledgements of full states sent before the spawn can still turn up
+afterwards, but they're all older than the baseline, so can't replace it.
+*/
+void SnapshotScheduler::SetBaseline(int peerID, int networkID, int stateID) {
+	auto i = peers.find(peerID);
+	if (i == peers.end()) {
+		return;
+	}
+	ObjectRecord& o		= GetObjectRecord(i->second, networkID);
+	o.priority			= 0.0f;
+	o.confirmedState	= stateID;
+}
+
+void SnapshotScheduler::ForgetObject(int peerID, int networkID) {
+	auto i = peers.find(peerID);
+	if (i == peers.end() || networkID >= (int)i->second.objects.size()) {
+		return;
+	}
+	i->second.objects[networkID] = ObjectRecord();
+}
+
+void SnapshotScheduler::WriteSnapshot(int peerID, int stateID, const Vector3* viewpoint, InterestManager& interest, SnapshotBuilder& builder, GameServer& server) {
+	auto peerIterator = peers.find(peerID);
+	if (peerIterator == peers.end()) {
+		return;
+	}
+	PeerRecord& peer = peerIterator->second;
+
+	//Unused budget can carry over, but only a tick's worth, so it can't build up into a burst
+	float bytesPerTick	= bytesPerSecond / tickRate;
+	peer.budget			= std::min(peer.budget + bytesPerTick, bytesPerTick * 2.0f);
+
+	if (viewpoint) {
+		interest.GetNearObjects(*viewpoint, nearObjects);
+	}
+	else {
+		nearObjects.clear();
+	}
+	float radius = interest.GetRelevantRadius();
+
+	//Both lists are in network ID order, so they can be merged in one pass
+	candidates.clear();
+	auto nearObject = nearObjects.begin();
+	for (GameObject* o : interest.GetAllObjects()) {
+		NetworkObject* n	= o->GetNetworkObject();
+		ObjectRecord& r		= GetObjectRecord(peer, n->GetNetworkID());
+
+		bool isNear = !viewpoint;
+		if (nearObject != nearObjects.end() && *nearObject == o) {
+			isNear = true;
+			++nearObject;
+		}
+		if (r.confirmedState >= 0 && !n->HasChangedSince(r.confirmedState)) {
+			r.priority = 0.0f; //the client already has this object's current state
+			continue;
+		}
+		//Only what was copied at the start of the tick - the world may have moved on since
+		float relevance = farPriority;
+		if (isNear) {
+			float distance = viewpoint ? (n->GetTickState().position - *viewpoint).Length() : 0.0f;
+			relevance = 2.0f - (distance / radius);
+		}
+		//Builds up every tick the object isn't sent, so nothing waits forever
+		r.priority += relevance * (1.0f + n->GetTickSpeed() * velocityWeight);
+		candidates.push_back({ r.priority, o });
+	}
+	std::sort(candidates.begin(), candidates.end(),
+		[](const Candidate& a, const Candidate& b) { return a.priority > b.priority; });
+
+	SnapshotHeader header;
+	header.sequence = peer.nextSequence;
+	header.stateID	= stateID;
+	builder.Begin(server, peerID, header);
+
+	SentPacket* sent = nullptr;
+	for (const Candidate& c : candidates) {
+		if (builder.GetSnapshotBytes() >= peer.budget) {
+			break;
+		}
+		NetworkObject* n	= c.object->GetNetworkObject();
+		ObjectRecord& r		= peer.objects[n->GetNetworkID()];
+
+		bool delta = r.confirmedState >= 0 && n->HasNetworkState(r.confirmedState);
+		if (!n->WritePacket(builder, delta, r.confirmedState)) {
+			continue;
+		}
+		r.priority = 0.0f;
+
+		int sequence = builder.GetHeader().sequence;
+		if (!sent || sent->sequence != sequence) {
+			sent = &peer.sentPackets[sequence % SentPacketCount];
+			sent->sequence	= sequence;
+			sent->acked		= false;
+			sent->fullStates.clear();
+		}
+		if (!delta) {
+			sent->fullStates.emplace_back(n->GetNetworkID(), stateID);
+		}
+	}
+	builder.End();
+
+	peer.nextSequence	= builder.GetNextSequence();
+	peer.budget		   -= builder.GetSnapshotBytes();
+}
+
+int SnapshotScheduler::GetMinimumConfirmedState(int networkID) const {
+	int minState = INT_MAX;
+	for (const auto& [peerID, peer] : peers) {
+		if (networkID < (int)peer.objects.size() && peer.objects[networkID].confirmedState >= 0) {
+			minState = std::min(minState, peer.objects[networkID].confirmedState);
+		}
+	}
+	return minState;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "Vector3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		class GameObject;
+		class GameServer;
+		class SnapshotBuilder;
+		class InterestManager;
+
+		/*
+		Decides what goes into each client's snapshot every tick. Each client
+		has a byte budget that refills at bytesPerSecond; objects that need
+		sending build up priority every tick they're left out - faster when
+		they're moving quickly or are close to the client's viewpoint - and
+		the highest priority objects are written until the budget runs out.
+		Objects that haven't changed since the client's baseline don't need
+		sending at all.
+
+		It also keeps track of which datagrams carried which full states, so
+		that once a client acknowledges a datagram, later deltas for those
+		objects can be built against a state the client definitely has.
+		*/
+		class SnapshotScheduler {
+		public:
+			SnapshotScheduler(int bytesPerSecond = 16 * 1024, float tickRate = 20.0f);
+			~SnapshotScheduler();
+
+			void SetBytesPerSecond(int bytes) {
+				bytesPerSecond = bytes;
+			}
+			int GetBytesPerSecond() const {
+				return bytesPerSecond;
+			}
+
+			void SetTickRate(float rate) {
+				tickRate = rate;
+			}
+
+			void AddPeer(int peerID);
+			void RemovePeer(int peerID);
+
+			//ackBits bit n is set if datagram (sequence - 1 - n) was also received
+			void OnAcknowledged(int peerID, int sequence, uint32_t ackBits);
+
+			//A client has been sent an object's spawn, along with its state at stateID
+			void SetBaseline(int peerID, int networkID, int stateID);
+			//A client has been told an object has gone - whatever gets its network ID next starts afresh
+			void ForgetObject(int peerID, int networkID);
+
+			//Writes and sends this tick's snapshot for one client. viewpoint can be null if the client has no player yet.
+			void WriteSnapshot(int peerID, int stateID, const Vector3* viewpoint, InterestManager& interest, SnapshotBuilder& builder, GameServer& server);
+
+			//The oldest state any client is having deltas built against - INT_MAX if there isn't one
+			int GetMinimumConfirmedState(int networkID) const;
+
+			//How many datagrams can be waiting for an acknowledgement
+			static const int SentPacketCount = 64;
+
+		protected:
+			struct ObjectRecord {
+				float	priority		= 0.0f;
+				int		confirmedState	= -1; //newest full state we know the client has
+			};
+
+			struct SentPacket {
+				int sequence	= -1;
+				bool acked		= false;
+				std::vector<std::pair<int, int>> fullStates; //network ID, state ID
+			};
+
+			struct PeerRecord {
+				int		nextSequence = 0;
+				float	budget		 = 0.0f;
+				std::vector<ObjectRecord>	objects; //indexed by network ID
+				std::vector<SentPacket>		sentPackets;
+			};
+
+			struct Candidate {
+				float		priority;
+				GameObject* object;
+			};
+
+			ObjectRecord& GetObjectRecord(PeerRecord& peer, int networkID);
+
+			std::map<int, PeerRecord> peers;
+
+			std::vector<GameObject*>	nearObjects;
+			std::vector<Candidate>		candidates;
+
+			int		bytesPerSecond;
+			float	tickRate;
+			float	velocityWeight;	//extra priority per unit of speed
+			float	farPriority;	//priority per tick for objects outside the relevant radius
+		};
+	}
+}
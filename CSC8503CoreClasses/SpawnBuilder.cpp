@@ -0,0 +1,101 @@
+#include "SpawnBuilder.h"
+#include "GameServer.h"
+#include "SessionRecording.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+void SpawnEntry::Write(BitWriter& stream, const StateQuantisation& q) const {
+	stream.WriteVarUInt(networkID);
+	stream.WriteBool(spawned);
+	if (!spawned) {
+		return;
+	}
+	stream.WriteVarUInt(prefab);
+	for (int i = 0; i < 3; ++i) {
+		stream.WriteBits(state.position[i], q.positionBits);
+	}
+	stream.WriteBits(state.orientation, 2 + q.orientationBits * 3);
+}
+
+void SpawnEntry::Read(BitReader& stream, const StateQuantisation& q) {
+	networkID	= stream.ReadVarNonNegative();
+	spawned		= stream.ReadBool();
+	if (!spawned) {
+		return;
+	}
+	prefab = stream.ReadVarNonNegative();
+	for (int i = 0; i < 3; ++i) {
+		state.position[i] = stream.ReadBits(q.positionBits);
+	}
+	state.orientation = stream.ReadBits(2 + q.orientationBits * 3);
+}
+
+SpawnBuilder::SpawnBuilder(int maxPacketSize) {
+	this->maxPacketSize = maxPacketSize;
+	buffer.resize(maxPacketSize);
+
+	entryCount	= 0;
+	server		= nullptr;
+	recorder	= nullptr;
+	peerID		= -1;
+	stateID		= -1;
+	packetsSent	= 0;
+}
+
+SpawnBuilder::~SpawnBuilder() {
+}
+
+void SpawnBuilder::Begin(GameServer& server, int peerID, int stateID) {
+	this->server	= &server;
+	this->peerID	= peerID;
+	this->stateID	= stateID;
+	BeginPacket();
+}
+
+void SpawnBuilder::BeginPacket() {
+	new (buffer.data()) SpawnPacket();
+	packetStream.Reset(buffer.data() + sizeof(GamePacket), maxPacketSize - sizeof(GamePacket));
+	packetStream.WriteVarUInt(stateID);
+	entryCount = 0;
+}
+
+void SpawnBuilder::AddEntry(const SpawnEntry& entry) {
+	entryStream.Reset(entryBuffer, sizeof(entryBuffer));
+	entry.Write(entryStream, quantisation);
+
+	int capacityBits = (maxPacketSize - (int)sizeof(GamePacket)) * 8;
+	if (entryCount > 0 && packetStream.GetBitsWritten() + entryStream.GetBitsWritten() > capacityBits) {
+		Flush();
+		BeginPacket();
+	}
+	packetStream.WriteStream(entryStream);
+	entryCount++;
+}
+
+void SpawnBuilder::End() {
+	Flush();
+	entryCount	= 0;
+	server		= nullptr;
+}
+
+void SpawnBuilder::Flush() {
+	if (entryCount == 0 || !server) {
+		return;
+	}
+	packetStream.Flush();
+
+	SpawnPacket* packet = (SpawnPacket*)buffer.data();
+	packet->size = (short)packetStream.GetBytesWritten();
+
+	if (peerID < 0) {
+		server->SendGlobalPacket(*packet);
+	}
+	else {
+		server->SendPacketToPeer(peerID, *packet);
+	}
+	if (recorder) {
+		recorder->RecordOutgoing(stateID, peerID, *packet);
+	}
+	packetsSent++;
+}
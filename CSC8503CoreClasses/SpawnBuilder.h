@@ -0,0 +1,103 @@
+#pragma once
+#include "NetworkBase.h"
+#include "NetworkState.h"
+#include "BitStream.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameServer;
+		class SessionRecorder;
+
+		//Followed by the bit packed state ID the spawned objects' states were taken at,
+		//then SpawnEntries until the end of the packet
+		struct SpawnPacket : public GamePacket {
+			SpawnPacket() {
+				type = Spawn_State;
+				size = 0;
+			}
+		};
+
+		/*
+		An object appearing for a client, or going away. A spawned object
+		comes with which prefab to create it from, and its whole quantised
+		state - the server treats that state as one the client already has,
+		as spawn packets are reliable, so the object's snapshots can be deltas
+		against it from then on.
+		*/
+		struct SpawnEntry {
+			int				networkID	= -1;
+			bool			spawned		= true;	//false for a despawn, which is just the ID
+			int				prefab		= -1;
+			QuantisedState	state;
+
+			void Write(BitWriter& stream, const StateQuantisation& q) const;
+			void Read(BitReader& stream, const StateQuantisation& q);
+		};
+
+		/*
+		Batches up everything that's appeared or gone for one client in a
+		tick - a client that's just connected can have hundreds of objects
+		to create - into as few packets as will hold it, rather than a
+		reliable packet per object.
+		*/
+		class SpawnBuilder {
+		public:
+			static const int DefaultMaxPacketSize = 1200;
+
+			SpawnBuilder(int maxPacketSize = DefaultMaxPacketSize);
+			~SpawnBuilder();
+
+			void SetQuantisation(const StateQuantisation& q) {
+				quantisation = q;
+			}
+			//Every packet sent is also written to the recorder, if there is one
+			void SetRecorder(SessionRecorder* r) {
+				recorder = r;
+			}
+
+			void Begin(GameServer& server, int peerID, int stateID);
+			void AddEntry(const SpawnEntry& entry);
+			void End();
+
+			int GetPacketsSent() const {
+				return packetsSent;
+			}
+
+			//Calls func(stateID, entry) on every entry of a received Spawn_State packet, in the order they were added
+			template<typename Func>
+			static void ReadEntries(GamePacket& packet, const StateQuantisation& q, Func&& func) {
+				BitReader stream((char*)&packet + sizeof(GamePacket), packet.size);
+				int stateID = stream.ReadVarNonNegative();
+				while (stream.GetBitsRemaining() >= 8) {
+					SpawnEntry entry;
+					entry.Read(stream, q);
+					if (stream.HasOverflowed()) {
+						return;
+					}
+					func(stateID, entry);
+				}
+			}
+
+		protected:
+			void BeginPacket();
+			void Flush();
+
+			StateQuantisation quantisation;
+
+			std::vector<char> buffer;
+			BitWriter	packetStream;
+			int			maxPacketSize;
+			int			entryCount;
+
+			char		entryBuffer[64];
+			BitWriter	entryStream;
+
+			GameServer*			server;
+			SessionRecorder*	recorder;
+			int					peerID;
+			int					stateID;
+
+			int packetsSent;
+		};
+	}
+}
@@ -0,0 +1,80 @@
+#include "WorkerPool.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorkerPool::WorkerPool(int threadCount) {
+	currentJob		= nullptr;
+	currentJobCount = 0;
+	nextJob			= 0;
+	busyThreads		= 0;
+	batchID			= 0;
+	quit			= false;
+
+	if (threadCount < 0) {
+		threadCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+	}
+	for (int i = 0; i < threadCount; ++i) {
+		threads.emplace_back(&WorkerPool::WorkerMain, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+void WorkerPool::ParallelFor(int jobCount, const std::function<void(int)>& job) {
+	if (threads.empty() || jobCount < 2) {
+		for (int i = 0; i < jobCount; ++i) {
+			job(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		currentJob		= &job;
+		currentJobCount = jobCount;
+		nextJob			= 0;
+		busyThreads		= (int)threads.size();
+		batchID++;
+	}
+	wake.notify_all();
+	RunJobs();
+
+	std::unique_lock<std::mutex> guard(lock);
+	finished.wait(guard, [&] { return busyThreads == 0; });
+	currentJob = nullptr;
+}
+
+void WorkerPool::RunJobs() {
+	for (int i = nextJob++; i < currentJobCount; i = nextJob++) {
+		(*currentJob)(i);
+	}
+}
+
+void WorkerPool::WorkerMain() {
+	int lastBatch = 0;
+	std::unique_lock<std::mutex> guard(lock);
+	while (true) {
+		wake.wait(guard, [&] { return quit || batchID != lastBatch; });
+		if (quit) {
+			return;
+		}
+		lastBatch = batchID;
+
+		guard.unlock();
+		RunJobs();
+		guard.lock();
+
+		if (--busyThreads == 0) {
+			finished.notify_one();
+		}
+	}
+}
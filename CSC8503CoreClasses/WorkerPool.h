@@ -0,0 +1,45 @@
+#pragma once
+#include <mutex>
+#include <condition_variable>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A fixed set of threads that sit idle until handed a batch of jobs.
+		ParallelFor hands out job indices in order, one at a time, to whichever
+		thread is free next - the calling thread included - and returns once
+		every job has finished. Put the most expensive jobs first, and the
+		batch finishes as early as it can.
+		*/
+		class WorkerPool {
+		public:
+			//Threads on top of the calling one, by default enough to fill the machine
+			WorkerPool(int threadCount = -1);
+			~WorkerPool();
+
+			//Includes the calling thread
+			int GetThreadCount() const {
+				return (int)threads.size() + 1;
+			}
+
+			void ParallelFor(int jobCount, const std::function<void(int)>& job);
+
+		protected:
+			void WorkerMain();
+			void RunJobs();
+
+			std::vector<std::thread>	threads;
+
+			std::mutex					lock;
+			std::condition_variable		wake;
+			std::condition_variable		finished;
+
+			const std::function<void(int)>*	currentJob;
+			int					currentJobCount;
+			std::atomic<int>	nextJob;
+			int					busyThreads;
+			int					batchID;	//counts up every batch, so waking threads know there's new work
+			bool				quit;
+		};
+	}
+}
@@ -0,0 +1,349 @@
+#include "GameLevel.h"
+#include "ServerGame.h"
+#include "ClientGame.h"
+#include "GameServer.h"
+#include "GameClient.h"
+#include "LoopbackNetwork.h"
+#include "NetworkStats.h"
+#include "SnapshotBuilder.h"
+#include "SessionRecording.h"
+#include "BitStream.h"
+#include "Debug.h"
+#include <fstream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+A client with nobody at the keyboard - it wanders about, turning every
+second or two, and jumps and dashes now and then.
+*/
+class BotClient {
+public:
+	BotClient(LoopbackNetwork& network, float tickRate, int inputRedundancy, unsigned int seed)
+		: game(level, client, tickRate), random(seed) {
+		level.InitWorld();
+		level.InitNetworkObjects();
+		client.Connect(network);
+		game.RegisterPacketHandlers();
+		game.SetQuantisation(level.GetNetworkQuantisation());
+		game.SetInputRedundancy(inputRedundancy);
+		turnTimer	= 0.0f;
+		heading		= 0.0f;
+	}
+
+	PlayerInput NextInput(float dt) {
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+		turnTimer -= dt;
+		if (turnTimer < 0.0f) {
+			heading		= chance(random) * 360.0f;
+			turnTimer	= 1.0f + chance(random);
+		}
+		PlayerInput input;
+		input.moveX		= -std::sin(Maths::DegreesToRadians(heading));
+		input.moveZ		= -std::cos(Maths::DegreesToRadians(heading));
+		input.aimYaw	= heading;
+		if (chance(random) < 0.05f) {
+			input.buttons |= PlayerInput::Jump;
+		}
+		if (chance(random) < 0.01f) {
+			input.buttons |= PlayerInput::Dash;
+		}
+		return input;
+	}
+
+	GameLevel	level;
+	GameClient	client;
+	ClientGame	game;
+
+protected:
+	std::mt19937	random;
+	float			turnTimer;
+	float			heading;
+};
+
+/*
+Keeps the packed entries of every snapshot the bots receive, to try the
+snapshot compression out on once the run is over.
+*/
+class SnapshotCollector : public PacketReceiver {
+public:
+	void ReceivePacket(int type, GamePacket* payload, int source) override {
+		std::vector<char> entryBytes;
+		if (SnapshotBuilder::ReadEntryBytes(*payload, entryBytes)) {
+			snapshots.emplace_back(std::move(entryBytes));
+		}
+	}
+	std::vector<std::vector<char>> snapshots;
+};
+
+/*
+How small each codec gets the recorded snapshots' entries, and how long
+it takes to encode and decode them - as time per snapshot, and as the
+time it would cost the server (encoding) and each client (decoding)
+every second, at the rate the bots received them.
+*/
+static void BenchmarkCodec(const char* label, const HuffmanCodec& codec, const std::vector<std::vector<char>>& snapshots, float snapshotsPerSecond) {
+	using Clock = std::chrono::steady_clock;
+	int64_t rawBytes	= 0;
+	int64_t codedBits	= 0;
+	for (const auto& s : snapshots) {
+		rawBytes	+= s.size();
+		codedBits	+= codec.GetEncodedBits(s.data(), (int)s.size());
+	}
+	std::vector<std::vector<char>> coded(snapshots.size());
+	for (size_t i = 0; i < snapshots.size(); ++i) {
+		coded[i].resize(snapshots[i].size() * 2 + 8); //codes are at most 15 bits
+	}
+	std::vector<char> decoded;
+	const int repeats = 10;
+
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < repeats; ++r) {
+		for (size_t i = 0; i < snapshots.size(); ++i) {
+			BitWriter stream(coded[i].data(), (int)coded[i].size());
+			codec.Encode(snapshots[i].data(), (int)snapshots[i].size(), stream);
+			stream.Flush();
+		}
+	}
+	float encodeTime = std::chrono::duration<float>(Clock::now() - start).count() / (repeats * snapshots.size());
+
+	bool matched = true;
+	start = Clock::now();
+	for (int r = 0; r < repeats; ++r) {
+		for (size_t i = 0; i < snapshots.size(); ++i) {
+			decoded.resize(snapshots[i].size());
+			BitReader stream(coded[i].data(), (int)coded[i].size());
+			matched &= codec.Decode(stream, decoded.data(), (int)decoded.size());
+		}
+	}
+	float decodeTime = std::chrono::duration<float>(Clock::now() - start).count() / (repeats * snapshots.size());
+
+	std::cout << "  " << label << ": " << (100.0f * codedBits / 8.0f / std::max<int64_t>(rawBytes, 1)) << "% of the size, encode "
+		<< (encodeTime * 1e6f) << "us, decode " << (decodeTime * 1e6f) << "us per snapshot - "
+		<< (encodeTime * snapshotsPerSecond * 1000.0f) << "ms/s server, " << (decodeTime * snapshotsPerSecond * 1000.0f) << "ms/s client"
+		<< (matched ? "" : " (DECODE FAILED)") << std::endl;
+}
+
+/*
+Runs a server and a number of bot clients in the one process, talking over
+a simulated network, and reports what the netcode costs and how well it
+copes. Everything is on the command line:
+
+	CSC8503NetBench [bots] [seconds] [latency ms] [jitter ms] [loss %]
+		[bandwidth per client, kB/s, 0 = no cap] [tick rate] [seed] [inputs per packet]
+		[snapshot thread, 0 or 1] [snapshot compression, 0 or 1] [file to write the snapshot byte table to]
+		[file to record the server's session to, for CSC8503Replay]
+
+Time is simulated, so it runs as fast as the machine can go, and the same
+arguments always give the same results - unless snapshots are written on
+their own thread, when they go out whenever that thread gets them done. Every five simulated seconds, and
+again at the end, it prints:
+	bandwidth	- kB/s sent by the server and by all the clients together
+	lost		- packets dropped by the network, or arriving too late to use
+	resent		- reliable packets the network lost, that had to be sent again
+	snapshot age - how many ms old the newest snapshot a client has is
+	corrections	- how far server states moved a client's predicted player
+
+At the end, the Huffman coding used for snapshot compression is tried on
+every snapshot the bots received - with the table built into the game,
+and with one built from this run. That table can be written out, ready
+to paste into SnapshotBuilder.cpp.
+*/
+int main(int argc, char** argv) {
+	int		botCount	= argc > 1 ? atoi(argv[1]) : 4;
+	float	duration	= argc > 2 ? (float)atof(argv[2]) : 30.0f;
+	float	latency		= argc > 3 ? (float)atof(argv[3]) / 1000.0f : 0.05f;
+	float	jitter		= argc > 4 ? (float)atof(argv[4]) / 1000.0f : 0.01f;
+	float	loss		= argc > 5 ? (float)atof(argv[5]) / 100.0f : 0.01f;
+	int		bandwidth	= argc > 6 ? atoi(argv[6]) * 1000 : 0;
+	float	tickRate	= argc > 7 ? (float)atof(argv[7]) : 20.0f;
+	int		seed		= argc > 8 ? atoi(argv[8]) : 0;
+	int		redundancy	= argc > 9 ? atoi(argv[9]) : 4;
+	bool	threaded	= argc > 10 ? atoi(argv[10]) != 0 : false;
+	bool	compressed	= argc > 11 ? atoi(argv[11]) != 0 : false;
+	const char* tableFile = argc > 12 && *argv[12] ? argv[12] : nullptr;
+	const char* sessionFile = argc > 13 && *argv[13] ? argv[13] : nullptr;
+
+	const float frameDT	= 1.0f / 60.0f;
+	const float tickDT	= 1.0f / tickRate;
+
+	LoopbackNetwork network(seed);
+	LoopbackNetwork::LinkSettings link;
+	link.latency	= latency;
+	link.jitter		= jitter;
+	link.loss		= loss;
+	link.bandwidth	= bandwidth;
+	network.SetLinkSettings(link, link);
+
+	GameLevel serverLevel;
+	serverLevel.InitWorld();
+	serverLevel.InitNetworkObjects();
+
+	GameServer server(network, botCount);
+	ServerGame serverGame(serverLevel, server, tickRate);
+	serverGame.RegisterPacketHandlers();
+	serverGame.SetQuantisation(serverLevel.GetNetworkQuantisation());
+	serverGame.SetSnapshotThread(threaded);
+	serverGame.SetSnapshotCompression(compressed);
+
+	//A recording can only be replayed exactly if the physics doesn't adapt to how long it took
+	SessionRecorder recorder;
+	if (sessionFile && recorder.Open(sessionFile, tickRate, serverLevel.GetNetworkQuantisation())) {
+		serverLevel.GetWorld().SetDeterministic(true);
+		serverGame.SetRecorder(&recorder);
+	}
+
+	std::vector<std::unique_ptr<BotClient>> bots;
+	for (int i = 0; i < botCount; ++i) {
+		bots.emplace_back(new BotClient(network, tickRate, redundancy, seed + i + 1));
+	}
+	SnapshotCollector snapshotCollector;
+	for (auto& bot : bots) {
+		bot->client.RegisterPacketHandler(Snapshot_State, &snapshotCollector);
+	}
+
+	std::cout << "NetBench: " << botCount << " bots, " << (latency * 1000.0f) << "ms latency, " << (jitter * 1000.0f)
+		<< "ms jitter, " << (loss * 100.0f) << "% loss, " << (bandwidth / 1000) << "kB/s cap, " << tickRate << "Hz" << std::endl;
+
+	struct Totals {
+		LoopbackNetwork::LinkStats	down;
+		LoopbackNetwork::LinkStats	up;
+		ClientGame::Stats			client;
+		float	ageTotal	= 0.0f;
+		int		ageSamples	= 0;
+	};
+	auto gatherClients = [&]() {
+		ClientGame::Stats total;
+		for (auto& bot : bots) {
+			const ClientGame::Stats& s = bot->game.GetStats();
+			total.snapshots			+= s.snapshots;
+			total.snapshotBytes		+= s.snapshotBytes;
+			total.corrections		+= s.corrections;
+			total.correctionTotal	+= s.correctionTotal;
+			total.correctionWorst	= std::max(total.correctionWorst, s.correctionWorst);
+		}
+		return total;
+	};
+	auto report = [&](const char* label, const Totals& from, const Totals& to, float seconds, float ageWorst) {
+		int		sent	= (to.down.packetsSent - from.down.packetsSent) + (to.up.packetsSent - from.up.packetsSent);
+		int		lost	= (to.down.packetsLost - from.down.packetsLost) + (to.up.packetsLost - from.up.packetsLost);
+		int		stale	= (to.down.packetsStale - from.down.packetsStale) + (to.up.packetsStale - from.up.packetsStale);
+		int		resent	= (to.down.packetsResent - from.down.packetsResent) + (to.up.packetsResent - from.up.packetsResent);
+		int		fixes	= to.client.corrections - from.client.corrections;
+		int		ages	= to.ageSamples - from.ageSamples;
+
+		std::cout << label
+			<< " down " << ((to.down.bytesSent - from.down.bytesSent) / seconds / 1000.0f) << "kB/s"
+			<< ", up " << ((to.up.bytesSent - from.up.bytesSent) / seconds / 1000.0f) << "kB/s"
+			<< ", lost " << (sent ? 100.0f * (lost + stale) / sent : 0.0f) << "%"
+			<< ", resent " << (sent ? 100.0f * resent / sent : 0.0f) << "%"
+			<< ", snapshot age " << (ages ? 1000.0f * tickDT * (to.ageTotal - from.ageTotal) / ages : 0.0f) << "ms avg "
+			<< (1000.0f * tickDT * ageWorst) << "ms worst"
+			<< ", " << fixes << " corrections " << (fixes ? (to.client.correctionTotal - from.client.correctionTotal) / fixes : 0.0f) << " avg "
+			<< to.client.correctionWorst << " worst" << std::endl;
+	};
+
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+
+	Totals	current;
+	Totals	lastReport;
+	Totals	first;
+	float	ageWorst	= 0.0f;
+	float	overallAgeWorst = 0.0f;
+	float	tickTimer	= 0.0f;
+	float	reportTimer = 0.0f;
+	int		frameCount	= (int)(duration / frameDT);
+	float	serverTickTime	= 0.0f;	//how long the main thread spends in ServerGame::Tick
+	int		serverTicks		= 0;
+
+	for (int frame = 0; frame < frameCount; ++frame) {
+		network.Update(frameDT);
+		server.UpdateServer();
+
+		bool ticked = false;
+		tickTimer += frameDT;
+		while (tickTimer >= tickDT) {
+			tickTimer -= tickDT;
+			serverLevel.UpdateSimulation(tickDT);
+			Clock::time_point tickStart = Clock::now();
+			serverGame.Tick();
+			serverTickTime += std::chrono::duration<float>(Clock::now() - tickStart).count();
+			serverTicks++;
+			ticked = true;
+		}
+		for (auto& bot : bots) {
+			bot->client.UpdateClient();
+			if (ticked) {
+				bot->game.Tick(bot->NextInput(tickDT));
+			}
+			bot->game.Update(frameDT);
+			bot->level.UpdateSimulation(frameDT);
+
+			int newest = bot->game.GetNewestSnapshotTick();
+			if (ticked && newest >= 0) {
+				float age = (float)(serverGame.GetStateID() - newest);
+				current.ageTotal	+= age;
+				current.ageSamples++;
+				ageWorst		= std::max(ageWorst, age);
+				overallAgeWorst = std::max(overallAgeWorst, age);
+			}
+		}
+		Debug::UpdateRenderables(frameDT);
+
+		reportTimer += frameDT;
+		if (reportTimer >= 5.0f || frame == frameCount - 1) {
+			current.down	= network.GetServerUploadStats();
+			current.up		= network.GetServerDownloadStats();
+			current.client	= gatherClients();
+			report("NetBench:", lastReport, current, reportTimer, ageWorst);
+			lastReport	= current;
+			ageWorst	= 0.0f;
+			reportTimer	= 0.0f;
+		}
+	}
+	serverGame.SetRecorder(nullptr);
+	if (recorder.IsOpen()) {
+		std::cout << "NetBench: recorded " << (recorder.GetBytesWritten() / 1024) << "kB of session to " << sessionFile << std::endl;
+		recorder.Close();
+	}
+	float realTime = std::chrono::duration<float>(Clock::now() - start).count();
+	std::cout << "NetBench: ran " << duration << "s in " << realTime << "s, server tick "
+		<< (serverTicks > 0 ? 1000.0f * serverTickTime / serverTicks : 0.0f) << "ms on the main thread"
+		<< (threaded ? " (snapshots on their own thread)" : "") << std::endl;
+	report("NetBench: overall", first, current, duration, overallAgeWorst);
+
+	const NetworkStats& serverStats = server.GetStats();
+	std::cout << "NetBench: server snapshot entries " << (int)(serverStats.GetDeltaRatio() * 100.0f) << "% deltas, "
+		<< serverGame.GetSpawnedCount() << " spawned objects at the end" << std::endl;
+	for (int type = 0; type < NetworkBase::MaxMessageTypes; ++type) {
+		const NetworkStats::Counter& sent		= serverStats.GetCounter(NetworkStats::Sent, type);
+		const NetworkStats::Counter& received	= serverStats.GetCounter(NetworkStats::Received, type);
+		if (sent.packets > 0 || received.packets > 0) {
+			std::cout << "  " << NetworkStats::GetMessageName(type) << ": sent " << sent.packets << " (" << sent.bytes << " bytes), received "
+				<< received.packets << " (" << received.bytes << " bytes)" << std::endl;
+		}
+	}
+
+	uint32_t frequencies[HuffmanCodec::SymbolCount] = {};
+	for (const auto& snapshot : snapshotCollector.snapshots) {
+		HuffmanCodec::CountSymbols(snapshot.data(), (int)snapshot.size(), frequencies);
+	}
+	HuffmanCodec trained;
+	trained.Build(frequencies);
+
+	float snapshotsPerSecond = snapshotCollector.snapshots.size() / (duration * std::max(botCount, 1));
+	std::cout << "NetBench: Huffman coding " << snapshotCollector.snapshots.size() << " snapshots' entries" << std::endl;
+	BenchmarkCodec("built in table", SnapshotBuilder::GetCodec(), snapshotCollector.snapshots, snapshotsPerSecond);
+	BenchmarkCodec("table from this run", trained, snapshotCollector.snapshots, snapshotsPerSecond);
+
+	if (tableFile) {
+		std::ofstream table(tableFile);
+		for (int i = 0; i < HuffmanCodec::SymbolCount; ++i) {
+			table << (i % 16 == 0 ? "\t" : " ") << frequencies[i] << (i + 1 < HuffmanCodec::SymbolCount ? "," : "") << (i % 16 == 15 ? "\n" : "");
+		}
+		std::cout << "NetBench: snapshot byte table written to " << tableFile << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,272 @@
+#include "GameLevel.h"
+#include "ServerGame.h"
+#include "GameServer.h"
+#include "GameClient.h"
+#include "LoopbackNetwork.h"
+#include "NetworkObject.h"
+#include "SnapshotBuilder.h"
+#include "SpawnBuilder.h"
+#include "SessionRecording.h"
+#include "Debug.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+Compares the snapshots in two recordings, in the order they were sent.
+Returns true if every one is identical.
+*/
+static bool CompareSessions(SessionPlayback& a, SessionPlayback& b) {
+	auto nextSnapshot = [](SessionPlayback& s, SessionPlayback::Record& r) {
+		while (s.Next(r)) {
+			if (r.kind == SessionRecord::Outgoing) {
+				return true;
+			}
+		}
+		return false;
+	};
+	a.Rewind();
+	b.Rewind();
+	SessionPlayback::Record ra;
+	SessionPlayback::Record rb;
+	int compared	= 0;
+	int different	= 0;
+	int firstTick	= -1;
+	while (true) {
+		bool hasA = nextSnapshot(a, ra);
+		bool hasB = nextSnapshot(b, rb);
+		if (!hasA || !hasB) {
+			if (hasA != hasB) {
+				std::cout << "Replay: one session has more snapshots than the other, from snapshot " << compared << " on" << std::endl;
+				different++;
+			}
+			break;
+		}
+		compared++;
+		bool same = ra.tick == rb.tick && ra.peer == rb.peer && ra.packet->size == rb.packet->size &&
+			memcmp(ra.packet, rb.packet, sizeof(GamePacket) + ra.packet->size) == 0;
+		if (!same) {
+			if (different == 0) {
+				firstTick = ra.tick;
+			}
+			different++;
+		}
+	}
+	std::cout << "Replay: compared " << compared << " snapshots, " << different << " different";
+	if (firstTick >= 0) {
+		std::cout << ", starting at tick " << firstTick;
+	}
+	std::cout << std::endl;
+	return different == 0;
+}
+
+/*
+Runs a fresh copy of the level through the recorded ticks, feeding it the
+same packets before each tick, and records what it sends. The simulation
+is stepped one tick at a time, as the headless server and NetBench do -
+sessions recorded in the windowed game, which simulates once a frame,
+won't replay exactly.
+*/
+static void ReplayServer(SessionPlayback& session, const std::string& outputFile) {
+	const SessionFileHeader& header = session.GetHeader();
+
+	//Enough clients to receive what the server sends, and whether it was compressing snapshots.
+	//If it was, but never managed to make one smaller, replaying without compression sends the same bytes.
+	int		peerCount	= 0;
+	bool	compressed	= false;
+	SessionPlayback::Record r;
+	session.Rewind();
+	while (session.Next(r)) {
+		peerCount = std::max(peerCount, r.peer + 1);
+		if (r.kind == SessionRecord::Outgoing && r.packet->type == Snapshot_State) {
+			compressed |= SnapshotBuilder::ReadHeader(*const_cast<GamePacket*>(r.packet)).compressed;
+		}
+	}
+	GameLevel level;
+	level.InitWorld();
+	level.InitNetworkObjects();
+	level.GetWorld().SetDeterministic(true);
+
+	LoopbackNetwork network;
+	GameServer		server(network, std::max(peerCount, 1));
+	std::vector<std::unique_ptr<GameClient>> clients;
+	for (int i = 0; i < peerCount; ++i) {
+		clients.emplace_back(new GameClient());
+		clients.back()->Connect(network);
+	}
+	ServerGame game(level, server, header.tickRate);
+	game.SetQuantisation(header.quantisation);
+	game.SetSnapshotCompression(compressed);
+
+	SessionRecorder recorder;
+	if (recorder.Open(outputFile, header.tickRate, header.quantisation)) {
+		game.SetRecorder(&recorder);
+	}
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+
+	const float dt	= 1.0f / header.tickRate;
+	int ticks		= 0;
+	session.Rewind();
+	while (session.Next(r)) {
+		if (r.kind == SessionRecord::Incoming) {
+			//The mapped file is read only, but nothing on the server writes to packets it receives
+			game.ReceivePacket(r.packet->type, const_cast<GamePacket*>(r.packet), r.peer);
+		}
+		else if (r.kind == SessionRecord::Tick) {
+			if (r.tick != game.GetStateID() + 1) {
+				std::cout << "Replay: expected tick " << (game.GetStateID() + 1) << ", the recording has " << r.tick << std::endl;
+			}
+			level.UpdateSimulation(dt);
+			game.Tick();
+			ticks++;
+
+			//Nobody is reading what the server sends, but it still has to go somewhere
+			network.Update(dt);
+			for (auto& c : clients) {
+				c->UpdateClient();
+			}
+			Debug::UpdateRenderables(dt);
+		}
+	}
+	game.SetRecorder(nullptr);
+	recorder.Close();
+
+	float time = std::chrono::duration<float>(Clock::now() - start).count();
+	std::cout << "Replay: server ran " << ticks << " ticks in " << time << "s - " << (ticks / std::max(time, 1e-6f)) << " ticks/s, "
+		<< (ticks * dt / std::max(time, 1e-6f)) << "x real time" << std::endl;
+}
+
+/*
+Feeds every snapshot sent to one client into a level of its own, through
+NetworkObject::ReadPacket, and plays the objects back a couple of ticks
+behind each one, the way ClientGame does - spawning and despawning
+whatever the server told it to along the way. The final positions are hashed,
+so that two builds can be checked against each other.
+*/
+static void ReplayClient(SessionPlayback& session, int peer) {
+	const SessionFileHeader& header = session.GetHeader();
+
+	SessionPlayback::Record r;
+	session.Rewind();
+	while (peer < 0 && session.Next(r)) {
+		if (r.kind == SessionRecord::Incoming && r.packet->type == Player_Connected) {
+			peer = r.peer;
+		}
+	}
+	GameLevel level;
+	level.InitWorld();
+	level.InitNetworkObjects();
+	const std::vector<NetworkObject*>& networkObjects = level.GetNetworkObjects();
+
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+
+	const float interpolationDelay = 2.0f;
+	int snapshots	= 0;
+	int entries		= 0;
+	int newestTick	= -1;
+	session.Rewind();
+	while (session.Next(r)) {
+		if (r.kind != SessionRecord::Outgoing || (r.peer != peer && r.peer != -1)) {
+			continue;
+		}
+		GamePacket& packet = *const_cast<GamePacket*>(r.packet);
+		if (packet.type == Spawn_State) {
+			SpawnBuilder::ReadEntries(packet, header.quantisation, [&](int stateID, const SpawnEntry& entry) {
+				if (!entry.spawned) {
+					level.DespawnNetworkObject(entry.networkID);
+				}
+				else if (NetworkObject* n = level.SpawnNetworkObject(entry.prefab, entry.networkID)) {
+					n->ReadBaseline(entry.state, stateID, header.quantisation);
+				}
+			});
+			continue;
+		}
+		if (packet.type != Snapshot_State) {
+			continue;
+		}
+		SnapshotBuilder::ReadEntries(packet, header.quantisation, [&](const SnapshotHeader& h, const SnapshotEntry& entry) {
+			if (entry.objectID < (int)networkObjects.size() && networkObjects[entry.objectID]) {
+				networkObjects[entry.objectID]->ReadPacket(h, entry, header.quantisation);
+			}
+			newestTick = std::max(newestTick, h.stateID);
+			entries++;
+		});
+		for (NetworkObject* o : networkObjects) {
+			if (o) {
+				o->UpdateInterpolation(newestTick - interpolationDelay, 1.0f);
+			}
+		}
+		snapshots++;
+	}
+	float time = std::chrono::duration<float>(Clock::now() - start).count();
+
+	//FNV-1a, over the bytes of every object's final position and orientation
+	uint64_t hash = 14695981039346656037ull;
+	auto hashBytes = [&](const void* data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ ((const uint8_t*)data)[i]) * 1099511628211ull;
+		}
+	};
+	for (NetworkObject* o : networkObjects) {
+		if (!o) {
+			continue;
+		}
+		Vector3		position	= o->GetGameObject().GetTransform().GetPosition();
+		Quaternion	orientation = o->GetGameObject().GetTransform().GetOrientation();
+		hashBytes(&position, sizeof(position));
+		hashBytes(&orientation, sizeof(orientation));
+	}
+	std::cout << "Replay: client " << peer << " read " << snapshots << " snapshots (" << entries << " entries) in " << time << "s - "
+		<< (snapshots / std::max(time, 1e-6f)) << " snapshots/s, final state hash " << std::hex << hash << std::dec << std::endl;
+}
+
+/*
+Plays back a session recorded by the server (NetBench can record one)
+offline, as fast as it'll go - as a repeatable load test, and to check
+that a build still does exactly what it did before:
+
+	CSC8503Replay [session file] [client to replay, -1 = the first to connect] [file to record the replay to]
+	CSC8503Replay compare [session file] [session file]
+
+The server is replayed from the packets it received, and the snapshots it
+sends this time are compared with the recorded ones - on the same build
+they should be identical, so the first tick that differs is where
+something stopped being deterministic. Then one client's snapshots are
+read back in, and the state they leave the level in is hashed. Replays
+of the same session by two builds can be compared with 'compare'.
+
+Exits with 1 if any snapshots differed.
+*/
+int main(int argc, char** argv) {
+	if (argc > 3 && std::string(argv[1]) == "compare") {
+		SessionPlayback a;
+		SessionPlayback b;
+		if (!a.Open(argv[2]) || !b.Open(argv[3])) {
+			return 2;
+		}
+		return CompareSessions(a, b) ? 0 : 1;
+	}
+	if (argc < 2) {
+		std::cout << "CSC8503Replay [session file] [client to replay] [file to record the replay to]" << std::endl;
+		std::cout << "CSC8503Replay compare [session file] [session file]" << std::endl;
+		return 2;
+	}
+	std::string sessionFile	= argv[1];
+	int			clientPeer	= argc > 2 ? atoi(argv[2]) : -1;
+	std::string outputFile	= argc > 3 ? argv[3] : sessionFile + ".replayed";
+
+	SessionPlayback session;
+	if (!session.Open(sessionFile)) {
+		return 2;
+	}
+	ReplayServer(session, outputFile);
+	ReplayClient(session, clientPeer);
+
+	SessionPlayback replayed;
+	if (!replayed.Open(outputFile)) {
+		return 2;
+	}
+	return CompareSessions(session, replayed) ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "RoomManager.h"
+#include "GameServer.h"
+#include "NetworkStats.h"
+#include "Debug.h"
+#include <fstream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+A dedicated server - any number of copies of the level, each one a separate
+match, ticked at a fixed rate with no window, renderer or keyboard.
+Everything is on the command line:
+
+	CSC8503Server [port] [players per room] [tick rate] [ticks to run, 0 = forever]
+		[max rooms] [rooms kept open] [worker threads, -1 = one per core]
+		[network stats CSV file]
+
+A set number of ticks are run back to back rather than in real time, to
+profile the simulation on its own - keep a few rooms open to see how the
+tick time grows with them. Every five seconds' worth of ticks, the average
+and worst tick times are printed, along with how each room is doing, and
+if a CSV file was given, a row of network stats is added to it.
+*/
+int main(int argc, char** argv) {
+	int		port			= argc > 1 ? atoi(argv[1]) : NetworkBase::GetDefaultPort();
+	int		playersPerRoom	= argc > 2 ? atoi(argv[2]) : 4;
+	float	tickRate		= argc > 3 ? (float)atof(argv[3]) : 20.0f;
+	int		tickCount		= argc > 4 ? atoi(argv[4]) : 0;
+	int		maxRooms		= argc > 5 ? atoi(argv[5]) : 1;
+	int		minRooms		= argc > 6 ? atoi(argv[6]) : 1;
+	int		workerThreads	= argc > 7 ? atoi(argv[7]) : -1;
+	const char* statsFile	= argc > 8 ? argv[8] : nullptr;
+
+	NetworkBase::Initialise();
+
+	GameServer	server(port, playersPerRoom * maxRooms);
+	RoomManager	rooms(server, tickRate, maxRooms, playersPerRoom, workerThreads);
+	rooms.SetMinimumRooms(minRooms);
+
+	std::ofstream statsLog;
+	if (statsFile) {
+		statsLog.open(statsFile);
+		server.GetStats().WriteCSVHeader(statsLog);
+	}
+
+	std::cout << "Server: running on port " << port << " at " << tickRate << "Hz, up to "
+		<< maxRooms << " rooms on " << rooms.GetThreadCount() << " threads" << std::endl;
+
+	using Clock = std::chrono::steady_clock;
+	const float				tickDT		= 1.0f / tickRate;
+	const Clock::duration	tickLength	= std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(tickDT));
+
+	Clock::time_point nextTick = Clock::now();
+	float	statsTime	= 0.0f;
+	float	worstTick	= 0.0f;
+	int		statsTicks	= 0;
+
+	for (int tick = 0; tickCount == 0 || tick < tickCount; ++tick) {
+		Clock::time_point start = Clock::now();
+
+		server.UpdateServer();
+		rooms.Tick();
+		Debug::UpdateRenderables(tickDT); //nothing will draw them, but they still need to expire
+
+		float tickTime = std::chrono::duration<float>(Clock::now() - start).count();
+		statsTime	+= tickTime;
+		worstTick	= std::max(worstTick, tickTime);
+		statsTicks++;
+		if (statsTicks == (int)(tickRate * 5.0f)) {
+			std::cout << "Server: " << rooms.GetPlayerCount() << " clients in " << rooms.GetRoomCount() << " rooms, "
+				<< (1000.0f * statsTime / statsTicks) << "ms average, "
+				<< (1000.0f * worstTick) << "ms worst" << std::endl;
+			rooms.PrintRooms();
+			if (statsLog.is_open()) {
+				server.GetStats().WriteCSVRow(statsLog, (tick + 1) * tickDT);
+			}
+			statsTime	= 0.0f;
+			worstTick	= 0.0f;
+			statsTicks	= 0;
+		}
+
+		nextTick += tickLength;
+		if (Clock::now() > nextTick + tickLength) {
+			nextTick = Clock::now(); //fallen too far behind to catch up, so don't try
+		}
+		if (tickCount == 0) {
+			std::this_thread::sleep_until(nextTick);
+		}
+	}
+	NetworkBase::Destroy();
+	return 0;
+}
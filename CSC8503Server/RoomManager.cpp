@@ -0,0 +1,180 @@
+#include "RoomManager.h"
+#include "GameServer.h"
+#include "GameLevel.h"
+#include "ServerGame.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+const float	costSmoothing	= 0.1f;		//how much each tick moves a room's average cost
+const float	maxThreadLoad	= 0.8f;		//leave some of every tick spare, for spikes
+const float	idleRoomTimeout = 60.0f;	//seconds an empty room stays open
+
+struct RoomManager::Room {
+	Room(int id, GameServer& server, float tickRate) : id(id), game(level, server, tickRate) {
+	}
+
+	int			id;
+	GameLevel	level;
+	ServerGame	game;
+
+	std::set<int> peers;
+
+	float	averageCost = 0.0f;	//seconds
+	int		overruns	= 0;	//ticks over budget since the last PrintRooms
+	int		idleTicks	= 0;
+};
+
+RoomManager::RoomManager(GameServer& server, float tickRate, int maxRooms, int playersPerRoom, int workerThreads)
+	: server(server), workers(workerThreads) {
+	this->tickRate			= tickRate;
+	this->maxRooms			= std::max(1, maxRooms);
+	this->playersPerRoom	= std::max(1, playersPerRoom);
+	roomBudget	= 0.5f / tickRate;
+	minRooms	= 0;
+	nextRoomID	= 0;
+
+	server.RegisterPacketHandler(Received_State, this, ClientPacket::MinimumSize);
+	server.RegisterPacketHandler(Player_Connected, this);
+	server.RegisterPacketHandler(Player_Disconnected, this);
+}
+
+RoomManager::~RoomManager() {
+}
+
+void RoomManager::SetMinimumRooms(int count) {
+	minRooms = std::min(count, maxRooms);
+	while ((int)rooms.size() < minRooms) {
+		OpenRoom();
+	}
+}
+
+RoomManager::Room* RoomManager::OpenRoom() {
+	Room* room = new Room(nextRoomID++, server, tickRate);
+	room->level.InitWorld();
+	room->level.InitNetworkObjects();
+	room->game.SetQuantisation(room->level.GetNetworkQuantisation());
+	rooms.emplace_back(room);
+
+	std::cout << "Server: opened room " << room->id << " (" << rooms.size() << " open)" << std::endl;
+	return room;
+}
+
+/*
+Rooms are filled up one at a time, rather than players being spread
+across them - fewer, fuller rooms get more matches out of every thread.
+*/
+RoomManager::Room* RoomManager::FindRoomForPlayer() {
+	Room* best = nullptr;
+	for (auto& room : rooms) {
+		if ((int)room->peers.size() >= playersPerRoom || room->averageCost > roomBudget) {
+			continue;
+		}
+		if (!best || room->peers.size() > best->peers.size()) {
+			best = room.get();
+		}
+	}
+	if (!best && (int)rooms.size() < maxRooms && HasTimeForNewRoom()) {
+		best = OpenRoom();
+	}
+	return best;
+}
+
+/*
+Guesses a new room will cost as much as the most expensive one already
+open, and checks that would still fit in the time all the threads have
+between them.
+*/
+bool RoomManager::HasTimeForNewRoom() const {
+	float total		= 0.0f;
+	float largest	= 0.0f;
+	for (auto& room : rooms) {
+		total	+= room->averageCost;
+		largest	= std::max(largest, room->averageCost);
+	}
+	return total + largest < maxThreadLoad * workers.GetThreadCount() / tickRate;
+}
+
+void RoomManager::CloseIdleRooms() {
+	for (int i = (int)rooms.size() - 1; i >= 0 && (int)rooms.size() > minRooms; --i) {
+		Room& room = *rooms[i];
+		room.idleTicks = room.peers.empty() ? room.idleTicks + 1 : 0;
+		if (room.idleTicks > idleRoomTimeout * tickRate) {
+			std::cout << "Server: closed idle room " << room.id << std::endl;
+			rooms.erase(rooms.begin() + i);
+		}
+	}
+}
+
+/*
+Rooms are handed to the threads most expensive first, so the slowest
+ones don't end up starting last. Nothing a room does touches any other
+room, and anything sent while they're ticking is queued up and sent
+once they've all finished.
+*/
+void RoomManager::Tick() {
+	CloseIdleRooms();
+
+	std::vector<Room*> order;
+	for (auto& room : rooms) {
+		order.push_back(room.get());
+	}
+	std::sort(order.begin(), order.end(), [](const Room* a, const Room* b) {
+		return a->averageCost > b->averageCost;
+	});
+
+	server.SetDeferredSends(true);
+	workers.ParallelFor((int)order.size(), [&](int i) {
+		TickRoom(*order[i]);
+	});
+	server.SetDeferredSends(false);
+}
+
+void RoomManager::TickRoom(Room& room) {
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+
+	room.level.UpdateSimulation(1.0f / tickRate);
+	room.game.Tick();
+
+	float cost = std::chrono::duration<float>(Clock::now() - start).count();
+	room.averageCost = room.game.GetStateID() == 0 ? cost : room.averageCost + (cost - room.averageCost) * costSmoothing;
+	if (cost > roomBudget) {
+		room.overruns++;
+	}
+}
+
+void RoomManager::ReceivePacket(int type, GamePacket* payload, int source) {
+	if (type == Player_Connected) {
+		Room* room = FindRoomForPlayer();
+		if (!room) {
+			std::cout << "Server: no room has space for a new client" << std::endl;
+			server.DisconnectPeer(source);
+			return;
+		}
+		peerRooms[source] = room;
+		room->peers.insert(source);
+		room->game.ReceivePacket(type, payload, source);
+		return;
+	}
+	auto i = peerRooms.find(source);
+	if (i == peerRooms.end()) {
+		return; //turned away when it connected
+	}
+	Room* room = i->second;
+	room->game.ReceivePacket(type, payload, source);
+
+	if (type == Player_Disconnected) {
+		room->peers.erase(source);
+		peerRooms.erase(i);
+	}
+}
+
+void RoomManager::PrintRooms() {
+	for (auto& room : rooms) {
+		std::cout << "  Room " << room->id << ": " << room->peers.size() << "/" << playersPerRoom << " players, tick "
+			<< room->game.GetStateID() << ", " << (1000.0f * room->averageCost) << "ms average, "
+			<< room->overruns << " ticks over budget" << std::endl;
+		room->overruns = 0;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "NetworkBase.h"
+#include "WorkerPool.h"
+#include <memory>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameServer;
+
+		/*
+		Lets one server process host lots of separate matches ("rooms"), each
+		with its own level, physics, and set of peers, all sharing the one
+		GameServer and its port. Every packet that comes in is passed on to
+		the room its peer was put in when it connected.
+
+		Every tick, the rooms are shared out across a pool of threads. A room
+		that regularly takes longer than its budget to tick stops taking new
+		players, and new rooms are only opened while there's enough spare
+		time across all the threads to tick them.
+		*/
+		class RoomManager : public PacketReceiver {
+		public:
+			RoomManager(GameServer& server, float tickRate, int maxRooms, int playersPerRoom, int workerThreads = -1);
+			~RoomManager();
+
+			//Rooms kept open even when nobody is in them
+			void SetMinimumRooms(int count);
+			//Seconds of a tick each room can take before it stops taking players
+			void SetRoomBudget(float seconds) {
+				roomBudget = seconds;
+			}
+
+			void Tick();
+
+			void ReceivePacket(int type, GamePacket* payload, int source) override;
+
+			int GetRoomCount() const {
+				return (int)rooms.size();
+			}
+			int GetPlayerCount() const {
+				return (int)peerRooms.size();
+			}
+			int GetThreadCount() const {
+				return workers.GetThreadCount();
+			}
+
+			//One line per room - players, tick, average cost, ticks over budget
+			void PrintRooms();
+
+		protected:
+			struct Room;
+
+			Room*	OpenRoom();
+			Room*	FindRoomForPlayer();
+			bool	HasTimeForNewRoom() const;
+			void	CloseIdleRooms();
+			void	TickRoom(Room& room);
+
+			GameServer&	server;
+			WorkerPool	workers;
+
+			float	tickRate;
+			float	roomBudget;
+			int		maxRooms;
+			int		minRooms;
+			int		playersPerRoom;
+			int		nextRoomID;
+
+			std::vector<std::unique_ptr<Room>>	rooms;
+			std::map<int, Room*>				peerRooms;
+		};
+	}
+}